@@ -6,7 +6,8 @@
 //
 //   Simulates:
 //   - Multi-tenant fairness (weights per tenant).
-//   - Multi-core execution (thread pool).
+//   - Multi-core execution (thread pool), global or per-core sharded run
+//     queues with batch work stealing.
 //   - Resource contention (mutexes) and Priority Inversion mitigation.
 //   - CoDel-inspired adaptive backpressure.
 //
@@ -24,16 +25,21 @@
 #include <barrier>
 #include <bit>
 #include <chrono>
+#include <cmath>
 #include <concepts>
 #include <condition_variable>
 #include <cstdint>
-#include <deque>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <expected>
+#include <filesystem>
 #include <format>
 #include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <numeric>
 #include <optional>
 #include <print>
@@ -42,10 +48,20 @@
 #include <ranges>
 #include <source_location>
 #include <span>
+#include <string>
 #include <string_view>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 // --------------------------- C++23 & System Utils ----------------------------
 
 namespace sys {
@@ -54,12 +70,40 @@ using Nano = std::chrono::nanoseconds;
 using Micro = std::chrono::microseconds;
 using TimePoint = std::chrono::time_point<std::chrono::steady_clock, Nano>;
 
-static inline uint64_t now_ns() {
+// Host monotonic clock, regardless of simulation mode.
+static inline uint64_t host_now_ns() {
     return std::chrono::duration_cast<Nano>(
         std::chrono::steady_clock::now().time_since_epoch()
     ).count();
 }
 
+// Discrete-event time base. While enabled, now_ns() reports simulated time,
+// so everything that timestamps through it (admission buckets, CoDel, task
+// timestamps, telemetry) follows the simulation. Owned by one VIRTUAL
+// scheduler at a time and advanced only by the thread driving it.
+class VirtualClock {
+    static inline std::atomic<bool> enabled_{false};
+    static inline std::atomic<uint64_t> now_{0};
+
+public:
+    static void enable(uint64_t start_ns) {
+        now_.store(start_ns, std::memory_order_relaxed);
+        enabled_.store(true, std::memory_order_release);
+    }
+    static void disable() { enabled_.store(false, std::memory_order_release); }
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    static uint64_t now() { return now_.load(std::memory_order_relaxed); }
+
+    // Time never moves backwards
+    static void advance_to(uint64_t t_ns) {
+        if (t_ns > now()) now_.store(t_ns, std::memory_order_relaxed);
+    }
+};
+
+static inline uint64_t now_ns() {
+    return VirtualClock::enabled() ? VirtualClock::now() : host_now_ns();
+}
+
 // Concept for a schedulable entity
 template<typename T>
 concept SchedulableEntity = requires(T t) {
@@ -103,8 +147,107 @@ public:
         if (min >= max) return min;
         return min + (next() % (max - min + 1));
     }
+
+    // Uniform in [0, 1), 53 bits of precision
+    double uniform() {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+};
+
+// CPU and NUMA layout. detect() reads /sys/devices/system/cpu: the online
+// list, then each CPU's nodeN link (or, without NUMA sysfs, its
+// physical_package_id, so sockets still group). Anything unreadable
+// degrades to one node holding hardware_concurrency() CPUs.
+struct CpuTopology {
+    std::vector<std::vector<int>> node_cpus; // Non-empty nodes, CPUs ascending
+    bool from_sysfs{false};                  // CPU ids are real and may be pinned
+
+    size_t nodes() const { return node_cpus.size(); }
+
+    static CpuTopology detect() {
+        CpuTopology topo;
+        const std::string root = "/sys/devices/system/cpu/";
+        auto online = read_line(root + "online");
+        std::vector<int> cpus = online ? parse_cpulist(*online) : std::vector<int>{};
+
+        std::map<int, std::vector<int>> by_node;
+        for (int cpu : cpus) {
+            std::string dir = std::format("{}cpu{}/", root, cpu);
+            int node = -1;
+            std::error_code ec;
+            for (const auto& e : std::filesystem::directory_iterator(dir, ec)) {
+                std::string name = e.path().filename().string();
+                if (name.starts_with("node") && name.size() > 4) {
+                    node = std::atoi(name.c_str() + 4);
+                    break;
+                }
+            }
+            if (node < 0) {
+                auto pkg = read_line(dir + "topology/physical_package_id");
+                node = pkg ? std::atoi(pkg->c_str()) : 0;
+            }
+            by_node[node].push_back(cpu);
+        }
+
+        for (auto& [node, list] : by_node) topo.node_cpus.push_back(std::move(list));
+        topo.from_sysfs = !topo.node_cpus.empty();
+        if (!topo.from_sysfs) topo = synthetic(1, std::max(1u, std::thread::hardware_concurrency()));
+        return topo;
+    }
+
+    // Even split of `cpus` logical CPUs over `nodes`; never pinned. For
+    // virtual runs and for modelling a machine other than the host.
+    static CpuTopology synthetic(size_t nodes, size_t cpus) {
+        CpuTopology topo;
+        nodes = std::max<size_t>(1, std::min(nodes, std::max<size_t>(1, cpus)));
+        topo.node_cpus.resize(nodes);
+        for (size_t c = 0; c < std::max<size_t>(1, cpus); ++c) {
+            topo.node_cpus[c * nodes / std::max<size_t>(1, cpus)].push_back(static_cast<int>(c));
+        }
+        return topo;
+    }
+
+    // "0-3,8-11" -> {0,1,2,3,8,9,10,11}
+    static std::vector<int> parse_cpulist(std::string_view s) {
+        std::vector<int> out;
+        while (!s.empty()) {
+            size_t comma = s.find(',');
+            std::string_view part = s.substr(0, comma);
+            size_t dash = part.find('-');
+            int lo = std::atoi(std::string(part.substr(0, dash)).c_str());
+            int hi = dash == std::string_view::npos ? lo : std::atoi(std::string(part.substr(dash + 1)).c_str());
+            for (int c = lo; c <= hi; ++c) out.push_back(c);
+            if (comma == std::string_view::npos) break;
+            s.remove_prefix(comma + 1);
+        }
+        return out;
+    }
+
+private:
+    static std::optional<std::string> read_line(const std::string& path) {
+        std::unique_ptr<std::FILE, decltype(&std::fclose)> f(std::fopen(path.c_str(), "r"), &std::fclose);
+        if (!f) return std::nullopt;
+        char buf[256];
+        if (!std::fgets(buf, sizeof(buf), f.get())) return std::nullopt;
+        std::string line(buf);
+        while (!line.empty() && (line.back() == '\n' || line.back() == ' ')) line.pop_back();
+        return line;
+    }
 };
 
+// Restricts the calling thread to one CPU. False where unsupported.
+static inline bool pin_current_thread(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
 } // namespace sys
 
 // --------------------------- Telemetry System --------------------------------
@@ -113,70 +256,214 @@ namespace telemetry {
 
 enum class Level { INFO, WARN, ERROR, DEBUG, TRACE };
 
+// Arguments are captured by value and formatted later on the drainer thread,
+// so only trivially copyable values with static lifetime referents qualify
+// (integers, enums, string literals).
+template<typename T>
+concept LogArg = std::is_trivially_copyable_v<std::remove_cvref_t<T>>;
+
 struct LogEvent {
     uint64_t timestamp;
     Level level;
     uint32_t thread_id;
-    std::array<char, 128> message; // Fixed size for zero-alloc
+    std::string_view fmt;                               // Points at a literal
+    void (*render)(const LogEvent&, std::string& out);  // Knows the argument types
+    alignas(16) std::array<std::byte, 64> args;         // Raw argument tuple
+};
+
+// Single-producer / single-consumer ring owned by one logging thread.
+// The producer never blocks: a full ring drops the event and counts it.
+class ThreadRing {
+    static constexpr size_t CAPACITY = 1024; // Power of two
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    std::array<LogEvent, CAPACITY> slots_;
+    alignas(64) std::atomic<uint64_t> head_{0};  // Written by producer
+    uint64_t cached_tail_{0};                    // Producer-private
+    alignas(64) std::atomic<uint64_t> tail_{0};  // Written by consumer
+    std::atomic<uint64_t> dropped_{0};
+
+public:
+    const uint32_t id;
+
+    explicit ThreadRing(uint32_t thread_id) : id(thread_id) {}
+
+    LogEvent* try_claim() {
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        if (h - cached_tail_ >= CAPACITY) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (h - cached_tail_ >= CAPACITY) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+        return &slots_[h & MASK];
+    }
+
+    // Makes the claimed slot visible to the drainer; the slot is complete.
+    void publish() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    template<typename Sink>
+    size_t drain(Sink&& sink) {
+        uint64_t t = tail_.load(std::memory_order_relaxed);
+        const uint64_t h = head_.load(std::memory_order_acquire);
+        for (uint64_t i = t; i != h; ++i) sink(slots_[i & MASK]);
+        tail_.store(h, std::memory_order_release);
+        return h - t;
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
 };
 
-// Lock-free ring buffer for high-speed logging
+// Lock-free telemetry: each thread logs into its own ThreadRing (a timestamp,
+// a format-string view and the raw arguments); a background drainer formats
+// and streams events to a file while the process runs.
 class RingLogger {
-    static constexpr size_t CAPACITY = 8192;
-    std::array<LogEvent, CAPACITY> buffer_;
-    std::atomic<size_t> head_{0};
-    std::atomic<size_t> tail_{0};
+    static constexpr size_t MAX_THREADS = 256;
+
+    std::array<std::atomic<ThreadRing*>, MAX_THREADS> rings_{};
+    std::atomic<uint32_t> ring_count_{0};
+    std::atomic<uint64_t> unregistered_drops_{0}; // Threads beyond MAX_THREADS
+
+    std::FILE* sink_{nullptr};
+    std::jthread drainer_;
+    std::string line_; // Drainer-private format buffer
 
 public:
-    void log(Level lvl, std::string_view fmt, auto&&... args) {
-        // Reserve slot
-        size_t current_head = head_.fetch_add(1, std::memory_order_relaxed);
-        LogEvent& ev = buffer_[current_head % CAPACITY];
-
-        ev.timestamp = sys::now_ns();
-        ev.level = lvl;
-        ev.thread_id = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
-        
-        // Format into fixed buffer (truncate if necessary)
-        auto result = std::format_to_n(ev.message.begin(), ev.message.size() - 1, fmt, std::forward<decltype(args)>(args)...);
-        *result.out = '\0';
+    RingLogger() = default;
+    RingLogger(const RingLogger&) = delete;
+    RingLogger& operator=(const RingLogger&) = delete;
+
+    ~RingLogger() {
+        stop_drain();
+        for (auto& r : rings_) delete r.load(std::memory_order_relaxed);
+    }
+
+    template<LogArg... Args>
+    void log(Level lvl, std::format_string<Args...> fmt, Args&&... args) {
+        using Tuple = std::tuple<std::decay_t<Args>...>;
+        static_assert(sizeof(Tuple) <= sizeof(LogEvent::args), "log arguments exceed inline storage");
+        static_assert(alignof(Tuple) <= alignof(LogEvent), "log arguments over-aligned");
+
+        ThreadRing* ring = local_ring();
+        LogEvent* ev = ring ? ring->try_claim() : nullptr;
+        if (!ev) return;
+
+        ev->timestamp = sys::now_ns();
+        ev->level = lvl;
+        ev->thread_id = ring->id;
+        ev->fmt = fmt.get();
+        ev->render = &render<Tuple>;
+        ::new (static_cast<void*>(ev->args.data())) Tuple(std::forward<Args>(args)...);
+        ring->publish();
     }
 
+    // Stream events to `path` from a background thread until stop_drain().
+    bool start_drain(const char* path) {
+        if (drainer_.joinable()) return false;
+        sink_ = std::fopen(path, "w");
+        if (!sink_) return false;
+        drainer_ = std::jthread([this](std::stop_token st) {
+            while (!st.stop_requested()) {
+                if (drain_to(sink_) == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            drain_to(sink_);
+            std::fflush(sink_);
+        });
+        return true;
+    }
+
+    void stop_drain() {
+        if (!drainer_.joinable()) return;
+        drainer_.request_stop();
+        drainer_.join();
+        std::fclose(sink_);
+        sink_ = nullptr;
+    }
+
+    // Flush whatever is still buffered to stdout. Only valid with no drainer
+    // attached (e.g. fallback when the telemetry file could not be opened).
     void dump_blocking() {
-        // Not thread safe, used at shutdown
+        if (drainer_.joinable()) return;
         std::print("\n=== Telemetry Dump ===\n");
-        size_t h = head_.load();
-        // Just dump the last N events if wrapped, or 0 to head
-        size_t start = (h > CAPACITY) ? (h - CAPACITY) : 0;
-        
-        for (size_t i = start; i < h; ++i) {
-            const auto& ev = buffer_[i % CAPACITY];
-            std::string_view lvl_str = "UNK";
-            switch(ev.level) {
-                case Level::INFO: lvl_str = "INF"; break;
-                case Level::WARN: lvl_str = "WRN"; break;
-                case Level::ERROR: lvl_str = "ERR"; break;
-                case Level::DEBUG: lvl_str = "DBG"; break;
-                case Level::TRACE: lvl_str = "TRC"; break;
-            }
-            std::print("[{:>12}] [{}] [TID:{:x}] {}\n", 
-                ev.timestamp, lvl_str, ev.thread_id, ev.message.data());
+        drain_to(stdout);
+    }
+
+    uint64_t dropped() const {
+        uint64_t n = unregistered_drops_.load(std::memory_order_relaxed);
+        uint32_t count = std::min<uint32_t>(ring_count_.load(std::memory_order_acquire), MAX_THREADS);
+        for (uint32_t i = 0; i < count; ++i) {
+            if (auto* r = rings_[i].load(std::memory_order_acquire)) n += r->dropped();
+        }
+        return n;
+    }
+
+private:
+    ThreadRing* local_ring() {
+        thread_local ThreadRing* ring = nullptr;
+        thread_local RingLogger* owner = nullptr;
+        if (owner == this) return ring;
+
+        uint32_t slot = ring_count_.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= MAX_THREADS) {
+            unregistered_drops_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        ring = new ThreadRing(slot); // Once per thread, off the steady-state path
+        owner = this;
+        rings_[slot].store(ring, std::memory_order_release);
+        return ring;
+    }
+
+    template<typename Tuple>
+    static void render(const LogEvent& ev, std::string& out) {
+        const auto& tup = *std::launder(reinterpret_cast<const Tuple*>(ev.args.data()));
+        std::apply([&](const auto&... a) {
+            std::vformat_to(std::back_inserter(out), ev.fmt, std::make_format_args(a...));
+        }, tup);
+    }
+
+    size_t drain_to(std::FILE* out) {
+        size_t total = 0;
+        uint32_t count = std::min<uint32_t>(ring_count_.load(std::memory_order_acquire), MAX_THREADS);
+        for (uint32_t i = 0; i < count; ++i) {
+            ThreadRing* r = rings_[i].load(std::memory_order_acquire);
+            if (!r) continue; // Slot claimed, ring not yet published
+            total += r->drain([&](const LogEvent& ev) {
+                std::string_view lvl_str = "UNK";
+                switch(ev.level) {
+                    case Level::INFO: lvl_str = "INF"; break;
+                    case Level::WARN: lvl_str = "WRN"; break;
+                    case Level::ERROR: lvl_str = "ERR"; break;
+                    case Level::DEBUG: lvl_str = "DBG"; break;
+                    case Level::TRACE: lvl_str = "TRC"; break;
+                }
+                line_.clear();
+                std::format_to(std::back_inserter(line_), "[{:>12}] [{}] [TID:{:x}] ",
+                    ev.timestamp, lvl_str, ev.thread_id);
+                ev.render(ev, line_);
+                line_.push_back('\n');
+                std::fwrite(line_.data(), 1, line_.size(), out);
+            });
         }
+        return total;
     }
 };
 
 static RingLogger global_logger;
 
-template<typename... Args>
-void info(std::string_view fmt, Args&&... args) {
+template<LogArg... Args>
+void info(std::format_string<Args...> fmt, Args&&... args) {
     global_logger.log(Level::INFO, fmt, std::forward<Args>(args)...);
 }
-template<typename... Args>
-void warn(std::string_view fmt, Args&&... args) {
+template<LogArg... Args>
+void warn(std::format_string<Args...> fmt, Args&&... args) {
     global_logger.log(Level::WARN, fmt, std::forward<Args>(args)...);
 }
-template<typename... Args>
-void debug(std::string_view fmt, Args&&... args) {
+template<LogArg... Args>
+void debug(std::format_string<Args...> fmt, Args&&... args) {
     // Compile out debug in "release" if needed, keeping enabled for sim
     global_logger.log(Level::DEBUG, fmt, std::forward<Args>(args)...);
 }
@@ -216,6 +503,10 @@ struct Task {
     // Resource Requirements (Simulation)
     // If resource_id > 0, task needs this lock to proceed.
     uint32_t required_resource_id{0}; 
+    // Optional second lock taken while holding the first (make_task orders
+    // the pair so the lower id is taken first).
+    // Holding one resource while parked on another is what forms PI chains.
+    uint32_t nested_resource_id{0};
 
     uint64_t start_time_ns{0};
     uint64_t finish_time_ns{0};
@@ -225,406 +516,2139 @@ struct Task {
     bool missed_deadline() const { return finish_time_ns > deadline_ns; }
 };
 
-// ---------------------- Resource Management (PIP) ----------------------------
-
-// Simulates Mutexes to demonstrate Priority Inheritance
-class ResourceManager {
-    struct Resource {
-        uint32_t id;
-        std::atomic<uint64_t> owner_task_id{0}; // 0 = free
-        std::atomic<uint8_t> highest_waiter_priority{255};
-        std::mutex mtx; // Internal protection
-    };
+// ------------------------------ Task Storage ---------------------------------
 
-    std::array<Resource, 16> resources_;
+// Index of a task slot in a TaskPool; NO_TASK terminates lists.
+using TaskRef = uint32_t;
+inline constexpr TaskRef NO_TASK = std::numeric_limits<TaskRef>::max();
 
+// Fixed-capacity task storage, allocated and touched once up front. A task
+// occupies one slot from submission to completion; tenant queues and
+// resource wait queues link slots through intrusive prev/next fields, so
+// queueing, stealing, parking and requeueing relink instead of moving Task
+// values, and none of them allocate.
+//
+// Free slots form a Treiber stack. The head packs {32-bit tag | 32-bit
+// index} and every push/pop bumps the tag, so a pop that raced a pop+push
+// of the same slot (ABA) fails its CAS instead of corrupting the stack.
+//
+// Each slot also records which run queue it is queued on (NOT_QUEUED when
+// it is not), written under that queue's lock and read without it, so a
+// priority boost can find a queued task; the reader re-checks under the lock.
+class TaskPool {
 public:
-    ResourceManager() {
-        for(uint32_t i=0; i<16; ++i) resources_[i].id = i + 1;
-    }
-
-    // Try to acquire resource. Returns true if acquired.
-    // If false, records the priority of the waiter to implement PIP.
-    bool try_acquire(uint32_t res_id, uint64_t task_id, Priority task_prio) {
-        if (res_id == 0 || res_id > 16) return true; // No resource needed
+    static constexpr uint32_t NOT_QUEUED = std::numeric_limits<uint32_t>::max();
 
-        Resource& res = resources_[res_id - 1];
-        std::lock_guard lk(res.mtx);
+private:
+    struct Slot {
+        Task task;
+        TaskRef prev{NO_TASK};
+        TaskRef next{NO_TASK};
+        std::atomic<TaskRef> next_free{NO_TASK}; // Read racily by stale poppers
+        std::atomic<uint32_t> queue{NOT_QUEUED};
+    };
 
-        if (res.owner_task_id == 0) {
-            res.owner_task_id = task_id;
-            return true;
-        }
+    const uint32_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> free_head_;
+    std::atomic<uint32_t> in_use_{0};
 
-        // Resource busy. Record priority pressure.
-        // In a real OS, we would traverse the dependency graph here.
-        // Here we just track the max priority waiting.
-        uint8_t p_val = static_cast<uint8_t>(task_prio);
-        uint8_t current_max = res.highest_waiter_priority.load();
-        
-        if (p_val < current_max) {
-             res.highest_waiter_priority.store(p_val);
-             telemetry::debug("Resource {} contention. Task {} (Prio {}) waiting. Boost required.", 
-                 res_id, task_id, p_val);
+public:
+    explicit TaskPool(uint32_t capacity)
+        : capacity_(std::min(capacity, NO_TASK - 1)),
+          slots_(new Slot[capacity_]()),
+          free_head_(capacity_ > 0 ? 0 : NO_TASK) {
+        for (uint32_t i = 0; i < capacity_; ++i) {
+            slots_[i].next_free.store(i + 1 < capacity_ ? i + 1 : NO_TASK, std::memory_order_relaxed);
         }
-        return false;
     }
 
-    void release(uint32_t res_id) {
-        if (res_id == 0 || res_id > 16) return;
-        Resource& res = resources_[res_id - 1];
-        std::lock_guard lk(res.mtx);
-        res.owner_task_id = 0;
-        res.highest_waiter_priority = 255; // Reset
-    }
-
-    // Check if a running task needs a priority boost because it holds a resource
-    // that a higher priority task is waiting for.
-    std::optional<Priority> check_priority_inheritance(uint64_t task_id) {
-        // Slow scan (O(N)) - ok for simulation
-        for (auto& res : resources_) {
-            std::lock_guard lk(res.mtx);
-            if (res.owner_task_id == task_id) {
-                uint8_t waiter_p = res.highest_waiter_priority.load();
-                if (waiter_p != 255) {
-                    return static_cast<Priority>(waiter_p);
-                }
+    // NO_TASK when the pool is exhausted.
+    TaskRef allocate() {
+        uint64_t head = free_head_.load(std::memory_order_acquire);
+        while (true) {
+            TaskRef idx = static_cast<TaskRef>(head);
+            if (idx == NO_TASK) return NO_TASK;
+            TaskRef next = slots_[idx].next_free.load(std::memory_order_relaxed);
+            if (free_head_.compare_exchange_weak(head, retag(head, next),
+                                                 std::memory_order_acq_rel, std::memory_order_acquire)) {
+                in_use_.fetch_add(1, std::memory_order_relaxed);
+                return idx;
             }
         }
-        return std::nullopt;
     }
-};
 
-// ------------------------ Admission & Queueing -------------------------------
+    void release(TaskRef idx) {
+        uint64_t head = free_head_.load(std::memory_order_relaxed);
+        do {
+            slots_[idx].next_free.store(static_cast<TaskRef>(head), std::memory_order_relaxed);
+        } while (!free_head_.compare_exchange_weak(head, retag(head, idx),
+                                                   std::memory_order_release, std::memory_order_relaxed));
+        in_use_.fetch_sub(1, std::memory_order_relaxed);
+    }
 
-// Advanced Token Bucket with CoDel-like adaptation
-class AdaptiveAdmission {
-    const uint64_t max_rate_;
-    double current_rate_;
-    double tokens_;
-    uint64_t last_refill_ns_;
-    
-    // Adaptation
-    uint64_t target_latency_ns_ = 100'000'000; // 100ms
-    std::deque<uint64_t> latency_history_;
+    Task& operator[](TaskRef idx) { return slots_[idx].task; }
+    const Task& operator[](TaskRef idx) const { return slots_[idx].task; }
+    TaskRef& prev(TaskRef idx) { return slots_[idx].prev; }
+    TaskRef& next(TaskRef idx) { return slots_[idx].next; }
 
-public:
-    AdaptiveAdmission(uint64_t rate_per_sec) 
-        : max_rate_(rate_per_sec), current_rate_(rate_per_sec), 
-          tokens_(rate_per_sec), last_refill_ns_(sys::now_ns()) {}
+    uint32_t queue_of(TaskRef idx) const { return slots_[idx].queue.load(std::memory_order_relaxed); }
+    void set_queue(TaskRef idx, uint32_t q) { slots_[idx].queue.store(q, std::memory_order_relaxed); }
 
-    bool can_admit() {
-        refill();
-        if (tokens_ >= 1.0) {
-            tokens_ -= 1.0;
-            return true;
-        }
-        return false;
+    uint32_t capacity() const { return capacity_; }
+    uint32_t in_use() const { return in_use_.load(std::memory_order_relaxed); }
+
+private:
+    static uint64_t retag(uint64_t head, TaskRef idx) {
+        return (((head >> 32) + 1) << 32) | idx;
     }
+};
 
-    void feedback_latency(uint64_t latency_ns) {
-        latency_history_.push_back(latency_ns);
-        if (latency_history_.size() > 50) latency_history_.pop_front();
+// Intrusive FIFO of pool slots. A task is on at most one list at a time;
+// the list's owner lock also covers the links of the tasks on it.
+struct TaskList {
+    TaskRef head{NO_TASK};
+    TaskRef tail{NO_TASK};
+    uint32_t count{0};
+
+    bool empty() const { return head == NO_TASK; }
+    size_t size() const { return count; }
+    TaskRef front() const { return head; }
+
+    void push_back(TaskPool& pool, TaskRef r) {
+        pool.prev(r) = tail;
+        pool.next(r) = NO_TASK;
+        (tail != NO_TASK ? pool.next(tail) : head) = r;
+        tail = r;
+        ++count;
+    }
 
-        // Simple P-Controller logic
-        // If average latency > target, reduce rate.
-        if (latency_history_.size() >= 10) {
-            uint64_t sum = std::reduce(latency_history_.begin(), latency_history_.end());
-            uint64_t avg = sum / latency_history_.size();
+    void push_front(TaskPool& pool, TaskRef r) {
+        pool.prev(r) = NO_TASK;
+        pool.next(r) = head;
+        (head != NO_TASK ? pool.prev(head) : tail) = r;
+        head = r;
+        ++count;
+    }
 
-            if (avg > target_latency_ns_ * 1.2) {
-                // Congestion detected, throttle down
-                current_rate_ = std::max(10.0, current_rate_ * 0.95);
-            } else if (avg < target_latency_ns_ * 0.8 && current_rate_ < max_rate_) {
-                // Recovery
-                current_rate_ = std::min((double)max_rate_, current_rate_ * 1.05);
-            }
-        }
+    TaskRef pop_front(TaskPool& pool) {
+        TaskRef r = head;
+        erase(pool, r);
+        return r;
     }
 
-private:
-    void refill() {
-        uint64_t now = sys::now_ns();
-        double elapsed_sec = (now - last_refill_ns_) / 1e9;
-        tokens_ = std::min((double)max_rate_, tokens_ + (elapsed_sec * current_rate_));
-        last_refill_ns_ = now;
+    void erase(TaskPool& pool, TaskRef r) {
+        TaskRef p = pool.prev(r);
+        TaskRef n = pool.next(r);
+        (p != NO_TASK ? pool.next(p) : head) = n;
+        (n != NO_TASK ? pool.prev(n) : tail) = p;
+        --count;
     }
 };
 
-// ----------------------- Tenant Logic (HWFQ) ---------------------------------
-
-struct TenantState {
-    uint64_t id;
-    uint64_t weight;     // For Weighted Fair Queuing
-    uint64_t vruntime;   // Virtual Runtime
-    
-    // Per-tenant queues by priority
-    std::array<std::deque<Task>, 4> queues; 
+// ---------------------- Resource Management (PIP) ----------------------------
 
-    // Metrics
-    uint64_t executed_ns{0};
-};
+// Simulates Mutexes to demonstrate Priority Inheritance.
+// A task that cannot get its resource is parked on the resource's wait queue
+// (its pool slot is linked there) and costs no worker time until
+// release_all() hands the resource over and returns it for re-enqueue.
+//
+// The PI graph (owners, waiters, effective priorities) spans resources, so it
+// is guarded by one mutex rather than per-resource locks: a boost walks the
+// chain waiter -> owner -> resource the owner is parked on -> its owner ...
+//
+// Lock order: a task takes its resources in ascending id order (make_task
+// normalizes nested requests), so no two tasks can wait on each other and
+// every chain ends at an owner that is running or runnable. Owner records
+// live in an array indexed by pool slot, so no acquire allocates.
+class ResourceManager {
+    static constexpr uint8_t NO_WAITER = 255;
+    static constexpr size_t MAX_CHAIN = 16; // Defensive bound; ordered acquisition keeps chains short
 
-// --------------------------- The Core Scheduler ------------------------------
+    struct Resource {
+        uint32_t id;
+        TaskRef owner{NO_TASK}; // NO_TASK = free
+        std::array<TaskList, 4> waiters; // FIFO per effective priority
 
-class HierarchicalScheduler {
-    struct CoreStats {
-        uint64_t tasks_run{0};
-        uint64_t idle_ns{0};
+        uint8_t highest_waiter_priority() const {
+            for (uint8_t p = 0; p < waiters.size(); ++p) {
+                if (!waiters[p].empty()) return p;
+            }
+            return NO_WAITER;
+        }
     };
 
-    // Configuration
-    const size_t num_cores_;
-    std::atomic<bool> running_{true};
-    
-    // Components
-    ResourceManager resource_mgr_;
-    AdaptiveAdmission admission_;
-    sys::Random rng_;
+    // Per pool slot: held resources index; also the blocked-on edge for
+    // chain walks. A slot owns something iff held_count > 0.
+    struct OwnerRecord {
+        uint8_t base_priority{0};
+        uint8_t effective_priority{0};
+        uint8_t held_count{0};
+        uint32_t blocked_on{0};          // Resource this owner is parked on (0 = none)
+        std::array<uint32_t, 2> held{};  // Resources currently owned, in acquisition order
+    };
 
-    // Tenant Management (Protected by global mutex for this sim)
-    std::mutex sched_mtx_;
-    std::condition_variable cv_;
-    std::map<uint64_t, TenantState> tenants_;
-    
-    // Thread Pool
-    std::vector<std::jthread> workers_;
-    std::vector<CoreStats> worker_stats_;
+    TaskPool& pool_;
+    std::vector<Resource> resources_;
+    std::unique_ptr<OwnerRecord[]> owners_; // Indexed by TaskRef
+    std::mutex mtx_;
 
-    // Metrics
-    std::atomic<uint64_t> dropped_tasks_{0};
-    std::atomic<uint64_t> completed_tasks_{0};
-    std::atomic<uint64_t> deadline_misses_{0};
-    std::atomic<uint64_t> pi_events_{0}; // Priority Inheritance events
+    std::atomic<uint64_t> boosts_{0};
+    std::atomic<uint64_t> chain_boosts_{0}; // Boosts applied at depth >= 2
 
 public:
-    HierarchicalScheduler(size_t cores, uint64_t base_rate) 
-        : num_cores_(cores), 
-          admission_(base_rate),
-          rng_(0xDEADBEEF),
-          worker_stats_(cores)
-    {
-        // Initialize default tenant
-        register_tenant(0, 100); 
+    explicit ResourceManager(TaskPool& pool, size_t num_resources = 16)
+        : pool_(pool), resources_(num_resources), owners_(std::make_unique<OwnerRecord[]>(pool.capacity())) {
+        for (uint32_t i = 0; i < resources_.size(); ++i) resources_[i].id = i + 1;
     }
 
-    void start() {
-        telemetry::info("Starting Scheduler with {} cores...", num_cores_);
-        for (size_t i = 0; i < num_cores_; ++i) {
-            workers_.emplace_back([this, i](std::stop_token st) {
-                this->worker_loop(i, st);
-            });
+    size_t size() const { return resources_.size(); }
+
+    // Returns true if the task owns all its resources (or needs none) and may
+    // run now. Otherwise it has been linked onto the wait queue of the first
+    // resource it lacks and its priority propagated along the blocking chain
+    // (PIP). on_boost(TaskRef, Priority) receives a boosted owner at the end
+    // of the chain (not parked: queued or running) so the caller can move it
+    // up in its run queue; it runs under this manager's lock.
+    template<typename OnBoost>
+    bool acquire_or_park(TaskRef ref, OnBoost&& on_boost) {
+        Task& t = pool_[ref];
+        if (t.required_resource_id == 0 && t.nested_resource_id == 0) return true;
+
+        std::lock_guard lk(mtx_);
+        for (uint32_t res_id : {t.required_resource_id, t.nested_resource_id}) {
+            Resource* res = lookup(res_id);
+            if (!res) continue; // No resource needed
+            if (res->owner == ref) continue; // Handed over by release_all()
+
+            if (res->owner == NO_TASK) {
+                res->owner = ref;
+                OwnerRecord& rec = record_for(ref);
+                rec.held[rec.held_count++] = res_id;
+                continue;
+            }
+
+            // Resource busy: park and push our priority down the chain.
+            uint8_t p_val = static_cast<uint8_t>(t.current_priority);
+            if (OwnerRecord& rec = owners_[ref]; rec.held_count > 0) {
+                rec.blocked_on = res_id;
+                p_val = std::min(p_val, rec.effective_priority);
+                t.current_priority = static_cast<Priority>(p_val);
+            }
+            telemetry::debug("Resource {} contention. Task {} (Prio {}) waiting on Task {}.", 
+                res_id, t.id, p_val, pool_[res->owner].id);
+            TaskRef owner = res->owner;
+            res->waiters[p_val].push_back(pool_, ref);
+            propagate(owner, p_val, on_boost);
+            return false;
         }
+        return true;
     }
 
-    void register_tenant(uint64_t id, uint64_t weight) {
-        std::lock_guard lk(sched_mtx_);
-        tenants_[id] = TenantState{id, weight, 0};
-        telemetry::info("Registered Tenant {} with weight {}", id, weight);
+    // Releases everything the task holds, newest first. Each resource with
+    // waiters goes straight to its highest-priority waiter, which inherits
+    // whatever priority is still waiting behind it; on_handoff(TaskRef)
+    // receives each new owner so the caller can make it runnable.
+    template<typename OnHandoff>
+    void release_all(TaskRef ref, OnHandoff&& on_handoff) {
+        const Task& t = pool_[ref];
+        if (t.required_resource_id == 0 && t.nested_resource_id == 0) return;
+
+        std::lock_guard lk(mtx_);
+        OwnerRecord& own = owners_[ref];
+        if (own.held_count == 0) return;
+        auto held = own.held;
+        size_t held_count = std::exchange(own.held_count, 0);
+
+        for (uint32_t res_id : std::span(held.data(), held_count) | std::views::reverse) {
+            Resource& res = *lookup(res_id);
+            uint8_t top = res.highest_waiter_priority();
+            if (top == NO_WAITER) {
+                res.owner = NO_TASK;
+                continue;
+            }
+            TaskRef next_ref = res.waiters[top].pop_front(pool_);
+            Task& next = pool_[next_ref];
+            res.owner = next_ref;
+
+            OwnerRecord& rec = record_for(next_ref);
+            rec.blocked_on = 0;
+            rec.held[rec.held_count++] = res_id;
+            rec.effective_priority = effective_priority(rec);
+            next.current_priority = static_cast<Priority>(
+                std::min(static_cast<uint8_t>(next.current_priority), rec.effective_priority));
+            on_handoff(next_ref);
+        }
     }
 
-    // Submission API: Returns expected<void, string> (C++23)
-    std::expected<void, std::string> submit(
-        uint64_t tenant_id, 
-        Priority prio, 
-        uint64_t cost_ns, 
-        uint64_t deadline_offset_ns,
-        uint32_t resource_need = 0
-    ) {
-        // 1. Admission Control
-        // Note: Global admission for simplicity, could be per-tenant
-        if (!admission_.can_admit()) {
-            return std::unexpected("Global backpressure active");
+    // Check if a running task needs a priority boost because it holds a resource
+    // that a higher priority task is (transitively) waiting for. O(1): tasks
+    // holding nothing never take the lock; owners are indexed by slot.
+    std::optional<Priority> check_priority_inheritance(TaskRef ref) {
+        const Task& t = pool_[ref];
+        if (t.required_resource_id == 0 && t.nested_resource_id == 0) return std::nullopt;
+
+        std::lock_guard lk(mtx_);
+        const OwnerRecord& rec = owners_[ref];
+        if (rec.held_count == 0 || rec.effective_priority >= rec.base_priority) {
+            return std::nullopt;
         }
+        return static_cast<Priority>(rec.effective_priority);
+    }
 
-        uint64_t now = sys::now_ns();
-        Task t{
-            .id = rng_.next(),
-            .tenant_id = tenant_id,
-            .base_priority = prio,
-            .current_priority = prio,
-            .enqueue_time_ns = now,
-            .deadline_ns = now + deadline_offset_ns,
-            .estimated_cost_ns = cost_ns,
-            .required_resource_id = resource_need
-        };
+    uint64_t boosts() const { return boosts_.load(std::memory_order_relaxed); }
+    uint64_t chain_boosts() const { return chain_boosts_.load(std::memory_order_relaxed); }
 
-        {
-            std::lock_guard lk(sched_mtx_);
-            auto it = tenants_.find(tenant_id);
-            if (it == tenants_.end()) {
-                return std::unexpected("Tenant not found");
-            }
-            
-            // Push to specific priority queue within tenant
-            it->second.queues[static_cast<size_t>(prio)].push_back(std::move(t));
-        }
-        
-        cv_.notify_one();
-        return {};
+private:
+    Resource* lookup(uint32_t res_id) {
+        if (res_id == 0 || res_id > resources_.size()) return nullptr;
+        return &resources_[res_id - 1];
     }
 
-    void shutdown() {
-        running_ = false;
-        cv_.notify_all();
-        // jthreads join automatically
+    // A slot's record, started fresh if it owns nothing yet
+    OwnerRecord& record_for(TaskRef ref) {
+        OwnerRecord& rec = owners_[ref];
+        if (rec.held_count == 0) {
+            uint8_t base = static_cast<uint8_t>(pool_[ref].base_priority);
+            rec = OwnerRecord{base, base, 0, 0, {}};
+        }
+        return rec;
     }
 
-    void print_stats() {
-        std::print("\n\n================ SCHEDULER REPORT ================\n");
-        std::print("Tasks Completed:  {}\n", completed_tasks_.load());
-        std::print("Tasks Dropped:    {}\n", dropped_tasks_.load());
-        std::print("Deadline Misses:  {}\n", deadline_misses_.load());
-        std::print("PI Boost Events:  {}\n", pi_events_.load());
-        
-        for(size_t i=0; i<num_cores_; ++i) {
-            std::print("Core {:02}: Tasks Run={}, Idle={}us\n", 
-                i, worker_stats_[i].tasks_run, worker_stats_[i].idle_ns/1000);
+    uint8_t effective_priority(const OwnerRecord& rec) {
+        uint8_t eff = rec.base_priority;
+        for (size_t i = 0; i < rec.held_count; ++i) {
+            eff = std::min(eff, lookup(rec.held[i])->highest_waiter_priority());
         }
+        return eff;
+    }
 
-        std::print("\n--- Tenant Fairness (Virtual Runtime) ---\n");
-        std::lock_guard lk(sched_mtx_);
-        for(const auto& [id, state] : tenants_) {
-            std::print("Tenant {:2}: Weight={:3}, Executed={:.2f}ms, VRuntime={}\n",
-                id, state.weight, state.executed_ns/1e6, state.vruntime);
+    // Transitive boost: raise `owner` to `prio`; if that owner is itself
+    // parked, move it up in that resource's waiter set and continue with the
+    // next owner down the chain. The last owner is not parked: on_boost
+    // moves it up in its run queue if it is still queued there.
+    template<typename OnBoost>
+    void propagate(TaskRef owner, uint8_t prio, OnBoost& on_boost) {
+        for (size_t depth = 0; depth < MAX_CHAIN; ++depth) {
+            OwnerRecord& rec = owners_[owner];
+            if (rec.held_count == 0) return;
+            if (prio >= rec.effective_priority) return; // Already at least this urgent
+
+            rec.effective_priority = prio;
+            boosts_.fetch_add(1, std::memory_order_relaxed);
+            if (depth > 0) chain_boosts_.fetch_add(1, std::memory_order_relaxed);
+
+            if (rec.blocked_on == 0) {
+                on_boost(owner, static_cast<Priority>(prio));
+                return;
+            }
+            // A parked task sits in waiters[current_priority]; relink it
+            Resource& res = *lookup(rec.blocked_on);
+            Task& parked = pool_[owner];
+            uint8_t cur = static_cast<uint8_t>(parked.current_priority);
+            if (prio < cur) {
+                res.waiters[cur].erase(pool_, owner);
+                parked.current_priority = static_cast<Priority>(prio);
+                res.waiters[prio].push_back(pool_, owner);
+            }
+            owner = res.owner;
         }
-        std::print("==================================================\n");
     }
+};
 
-private:
-    void worker_loop(size_t core_id, std::stop_token st) {
-        while (!st.stop_requested() && running_) {
-            Task task_to_run;
-            bool found = false;
+// ------------------------------- Live Metrics --------------------------------
 
-            {
-                std::unique_lock lk(sched_mtx_);
-                // Wait for work or shutdown
-                cv_.wait(lk, [&] { 
-                    return !running_ || has_runnable_tasks(); 
-                });
+// HDR-style log-linear histogram of nanosecond values: exact below 32, then
+// 16 buckets per power of two (<= 6.25% relative error), saturating at 2^40ns
+// (~18 minutes). Recording is a relaxed fetch_add, so any thread may record
+// and any other may read concurrently; a reader sees each bucket atomically
+// but not the set as one instant.
+class WaitHistogram {
+public:
+    static constexpr int SUB_BITS = 4;                 // 2^SUB_BITS buckets per octave
+    static constexpr size_t SUB = size_t{1} << SUB_BITS;
+    static constexpr int MAX_BITS = 40;                // Values clamp to 2^MAX_BITS - 1
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS - 1) * SUB + 2 * SUB;
 
-                if (!running_) break;
+    using Counts = std::array<uint64_t, BUCKETS>;
 
-                // ---------------------------------------------------------
-                // SCHEDULING ALGORITHM: Hierarchical Weighted Fair Queuing
-                // ---------------------------------------------------------
-                // 1. Select Tenant with lowest Virtual Runtime (CFS-style)
-                // 2. Select highest priority task within Tenant
-                
-                TenantState* best_tenant = nullptr;
-                uint64_t min_vruntime = std::numeric_limits<uint64_t>::max();
-
-                for (auto& [id, tenant] : tenants_) {
-                    if (tenant_has_tasks(tenant)) {
-                        // vruntime = executed_time / weight
-                        // Lower vruntime means this tenant is "starved" relative to weight
-                        if (tenant.vruntime < min_vruntime) {
-                            min_vruntime = tenant.vruntime;
-                            best_tenant = &tenant;
-                        }
-                    }
-                }
+    static size_t bucket_of(uint64_t v) {
+        v = std::min(v, (uint64_t{1} << MAX_BITS) - 1);
+        int shift = std::max(0, static_cast<int>(std::bit_width(v)) - (SUB_BITS + 1));
+        return static_cast<size_t>(shift) * SUB + static_cast<size_t>(v >> shift);
+    }
 
-                if (best_tenant) {
-                    // Pick task from highest priority queue
-                    for (size_t p = 0; p < 4; ++p) {
-                        if (!best_tenant->queues[p].empty()) {
-                            task_to_run = std::move(best_tenant->queues[p].front());
-                            best_tenant->queues[p].pop_front();
-                            
-                            // Penalize tenant vruntime
-                            // Delta VRuntime = ExecutionTime * (RefWeight / TenantWeight)
-                            // We approximate execution time with estimated cost for scheduling decision
-                            uint64_t penalty = task_to_run.estimated_cost_ns * (1024 / best_tenant->weight);
-                            best_tenant->vruntime += penalty;
-                            
-                            found = true;
-                            break;
-                        }
-                    }
-                }
-            } // unlock
+    // Smallest value that lands in bucket i
+    static uint64_t lower_bound(size_t i) {
+        if (i < 2 * SUB) return i;
+        size_t shift = i / SUB - 1;
+        return static_cast<uint64_t>(i - shift * SUB) << shift;
+    }
 
-            if (found) {
-                execute_task(core_id, task_to_run);
-            } else {
-                // Spin lightly or yield if truly empty (shouldn't happen due to CV)
-                std::this_thread::yield();
-            }
-        }
+    // Largest value that lands in bucket i (HDR "highest equivalent value")
+    static uint64_t upper_bound(size_t i) {
+        return i + 1 < BUCKETS ? lower_bound(i + 1) - 1 : (uint64_t{1} << MAX_BITS) - 1;
     }
 
-    bool has_runnable_tasks() const {
-        for (const auto& [id, tenant] : tenants_) {
-            if (tenant_has_tasks(tenant)) return true;
-        }
-        return false;
+    void record(uint64_t v) {
+        buckets_[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t seen = max_.load(std::memory_order_relaxed);
+        while (v > seen && !max_.compare_exchange_weak(seen, v, std::memory_order_relaxed)) {}
+    }
+
+    void read(Counts& out) const {
+        for (size_t i = 0; i < BUCKETS; ++i) out[i] = buckets_[i].load(std::memory_order_relaxed);
     }
 
-    bool tenant_has_tasks(const TenantState& t) const {
-        for (const auto& q : t.queues) {
-            if (!q.empty()) return true;
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding quantile q of `counts`
+    static uint64_t quantile(const Counts& counts, double q) {
+        uint64_t total = std::accumulate(counts.begin(), counts.end(), uint64_t{0});
+        if (total == 0) return 0;
+        auto rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return upper_bound(i);
         }
-        return false;
+        return upper_bound(BUCKETS - 1);
     }
 
-    void execute_task(size_t core_id, Task& t) {
-        t.start_time_ns = sys::now_ns();
-        worker_stats_[core_id].tasks_run++;
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> max_{0};
+};
 
-        // 1. Resource Acquisition Check
-        if (t.required_resource_id != 0) {
-            bool acquired = resource_mgr_.try_acquire(t.required_resource_id, t.id, t.current_priority);
-            if (!acquired) {
-                // TASK BLOCKED.
-                // In a real kernel, we would park the thread.
-                // In this simulation, we put it back in the queue but treat it as "waiting".
-                // However, for simplified logic here, we will just re-queue it immediately
-                // but increment a 'blocked' counter to avoid infinite spin without progress.
-                // (Simplification: Just yield and retry for this sim)
-                
-                // Simulate context switch cost
-                busy_wait_ns(2000); 
-                
-                {
-                    std::lock_guard lk(sched_mtx_);
-                    tenants_[t.tenant_id].queues[static_cast<int>(t.current_priority)].push_front(std::move(t));
-                }
-                return; 
-            }
-        }
+// Per-tenant counters mirrored out of the shard-locked run queues so that a
+// snapshot never takes a scheduler lock. Writers already hold the shard lock
+// (depth, vruntime) or own the task (executed, waits); all updates are
+// relaxed, and readers get per-field, not cross-field, consistency.
+struct TenantMetrics {
+    std::array<std::atomic<int64_t>, 4> depth{}; // Queued tasks per priority, all shards
+    std::atomic<uint64_t> executed_ns{0};
+    std::atomic<uint64_t> vruntime{0};           // Sum of vruntime charged on every shard
+    std::atomic<uint64_t> weight{0};
+    WaitHistogram waits;                         // start - enqueue of each dispatched task
+};
 
-        // 2. Check for Priority Inheritance Logic
-        // While running, this task might be holding a lock that a CRITICAL task wants.
-        // We simulate "checking" periodically or before running.
-        auto boost_prio = resource_mgr_.check_priority_inheritance(t.id);
-        if (boost_prio.has_value() && boost_prio.value() < t.current_priority) {
-            telemetry::info("PIP: Task {} boosted from {} to {}", 
-                t.id, to_string(t.current_priority), to_string(boost_prio.value()));
-            t.current_priority = boost_prio.value();
-            pi_events_++;
+// Point-in-time view returned by HierarchicalScheduler::snapshot(). Built
+// from relaxed atomic reads only; depths may briefly lag a steal in flight.
+struct SchedulerSnapshot {
+    struct Tenant {
+        uint64_t id{0};
+        uint64_t weight{0};
+        uint32_t home_node{0};
+        std::array<uint64_t, 4> depth{};  // Queued tasks per priority
+        uint64_t executed_ns{0};
+        uint64_t vruntime{0};             // Charged vruntime, summed over shards
+        int64_t lag{0};                   // Weighted mean vruntime - vruntime; > 0 means owed service
+        uint64_t admitted{0};
+        uint64_t rejected{0};
+        WaitHistogram::Counts waits{};
+        uint64_t wait_max_ns{0};
+
+        uint64_t wait_quantile(double q) const { return WaitHistogram::quantile(waits, q); }
+    };
+
+    uint64_t taken_ns{0};
+    uint64_t completed{0};
+    uint64_t dropped{0};
+    uint64_t deadline_misses{0};
+    size_t pool_in_use{0};
+    std::array<uint64_t, 4> depth{}; // Per priority, all tenants
+    std::vector<Tenant> tenants{};   // Registration order
+
+    // One line, no trailing newline. Histograms as [[upper_ns, count], ...]
+    // over non-empty buckets.
+    std::string to_json_line() const {
+        std::string out;
+        auto it = std::back_inserter(out);
+        std::format_to(it, "{{\"t\":{},\"completed\":{},\"dropped\":{},\"deadline_misses\":{},"
+            "\"pool_in_use\":{},\"depth\":[{},{},{},{}],\"tenants\":[",
+            taken_ns, completed, dropped, deadline_misses, pool_in_use, depth[0], depth[1], depth[2], depth[3]);
+        for (size_t k = 0; k < tenants.size(); ++k) {
+            const Tenant& t = tenants[k];
+            std::format_to(it, "{}{{\"id\":{},\"weight\":{},\"node\":{},\"depth\":[{},{},{},{}],"
+                "\"executed_ns\":{},\"vruntime\":{},\"lag\":{},\"admitted\":{},\"rejected\":{},"
+                "\"wait_ns\":{{\"p50\":{},\"p99\":{},\"p999\":{},\"max\":{},\"hist\":[",
+                k ? "," : "", t.id, t.weight, t.home_node, t.depth[0], t.depth[1], t.depth[2], t.depth[3],
+                t.executed_ns, t.vruntime, t.lag, t.admitted, t.rejected,
+                t.wait_quantile(0.50), t.wait_quantile(0.99), t.wait_quantile(0.999), t.wait_max_ns);
+            bool first = true;
+            for (size_t i = 0; i < t.waits.size(); ++i) {
+                if (t.waits[i] == 0) continue;
+                std::format_to(it, "{}[{},{}]", first ? "" : ",", WaitHistogram::upper_bound(i), t.waits[i]);
+                first = false;
+            }
+            out += "]}}";
         }
+        out += "]}";
+        return out;
+    }
+
+    // Binary layout (host byte order, like the trace format):
+    //   Header, then per tenant: TenantRecord followed by
+    //   bucket_count x BucketRecord for its non-empty buckets.
+    struct Header {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t tenant_count;
+        uint64_t taken_ns;
+        uint64_t completed;
+        uint64_t dropped;
+        uint64_t deadline_misses;
+        uint64_t pool_in_use;
+        std::array<uint64_t, 4> depth;
+    };
+    struct TenantRecord {
+        uint64_t id, weight, executed_ns, vruntime;
+        int64_t lag;
+        uint64_t admitted, rejected, wait_max_ns;
+        std::array<uint64_t, 4> depth;
+        uint32_t home_node;
+        uint32_t bucket_count;
+    };
+    struct BucketRecord {
+        uint32_t index; // WaitHistogram bucket; bounds via lower_bound()/upper_bound()
+        uint32_t reserved;
+        uint64_t count;
+    };
+    static constexpr std::array<char, 8> MAGIC{'H', 'W', 'F', 'Q', 'S', 'N', 'P', '1'};
+    static constexpr uint32_t VERSION = 1;
+
+    std::vector<std::byte> to_binary() const {
+        std::vector<std::byte> out;
+        auto put = [&out](const auto& rec) {
+            size_t at = out.size();
+            out.resize(at + sizeof(rec));
+            std::memcpy(out.data() + at, &rec, sizeof(rec));
+        };
+        put(Header{MAGIC, VERSION, static_cast<uint32_t>(tenants.size()), taken_ns, completed, dropped,
+                   deadline_misses, pool_in_use, depth});
+        for (const Tenant& t : tenants) {
+            auto buckets = static_cast<uint32_t>(std::ranges::count_if(t.waits, [](uint64_t c) { return c != 0; }));
+            put(TenantRecord{t.id, t.weight, t.executed_ns, t.vruntime, t.lag, t.admitted, t.rejected,
+                             t.wait_max_ns, t.depth, t.home_node, buckets});
+            for (size_t i = 0; i < t.waits.size(); ++i) {
+                if (t.waits[i] != 0) put(BucketRecord{static_cast<uint32_t>(i), 0, t.waits[i]});
+            }
+        }
+        return out;
+    }
+};
+
+// ------------------------ Admission & Queueing -------------------------------
+
+// Token bucket packed into one 64-bit word so refill+take is a single CAS:
+//   [ 40-bit refill timestamp (us since construction) | 24-bit tokens (1/256) ]
+// The timestamp wraps after ~12.7 days; differences are taken modulo 2^40.
+// Burst capacity is therefore capped at 65535 tokens.
+class AtomicTokenBucket {
+    static constexpr int TOKEN_BITS = 24;
+    static constexpr uint64_t TOKEN_MASK = (uint64_t{1} << TOKEN_BITS) - 1;
+    static constexpr uint64_t TIME_MASK = (uint64_t{1} << (64 - TOKEN_BITS)) - 1;
+    static constexpr uint64_t UNIT = 256; // Fixed-point units per token
+
+    const uint64_t epoch_ns_;
+    std::atomic<uint64_t> capacity_units_;
+    std::atomic<uint64_t> rate_units_; // Refill rate, units per second
+    std::atomic<uint64_t> state_;
+
+public:
+    AtomicTokenBucket(double rate_per_sec, double burst_tokens)
+        : epoch_ns_(sys::now_ns()),
+          capacity_units_(to_capacity(burst_tokens)),
+          rate_units_(static_cast<uint64_t>(rate_per_sec * UNIT)),
+          state_(capacity_units_.load()) {}
+
+    // Takes up to n tokens (all-or-nothing unless `partial`); returns the grant.
+    // If `spilled` is given it receives the whole tokens that refill would have
+    // credited beyond capacity (credit an idle owner did not use).
+    size_t try_take(size_t n, bool partial = false, uint64_t* spilled = nullptr) {
+        uint64_t cur = state_.load(std::memory_order_relaxed);
+        const uint64_t now_us = ((sys::now_ns() - epoch_ns_) / 1000) & TIME_MASK;
+        while (true) {
+            uint64_t last_us = cur >> TOKEN_BITS;
+            uint64_t units = cur & TOKEN_MASK;
+            uint64_t overflow = refill(now_us, last_us, units);
+
+            uint64_t avail = units / UNIT;
+            size_t grant = partial ? static_cast<size_t>(std::min<uint64_t>(n, avail)) : (avail >= n ? n : 0);
+            uint64_t next = (last_us << TOKEN_BITS) | (units - grant * UNIT);
+            if (grant == 0 && next == cur) return 0;
+            if (state_.compare_exchange_weak(cur, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                if (spilled) *spilled = overflow / UNIT;
+                return grant;
+            }
+        }
+    }
+
+    // Returns tokens (refunds, lent credit); anything above capacity is lost.
+    void deposit(uint64_t tokens) {
+        if (tokens == 0) return;
+        uint64_t cur = state_.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            uint64_t cap = capacity_units_.load(std::memory_order_relaxed);
+            uint64_t units = std::min(cap, (cur & TOKEN_MASK) + tokens * UNIT);
+            next = (cur & ~TOKEN_MASK) | units;
+        } while (!state_.compare_exchange_weak(cur, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+    }
+
+    void set_rate(double rate_per_sec) {
+        rate_units_.store(static_cast<uint64_t>(rate_per_sec * UNIT), std::memory_order_relaxed);
+    }
+
+    void set_rate(double rate_per_sec, double burst_tokens) {
+        capacity_units_.store(to_capacity(burst_tokens), std::memory_order_relaxed);
+        set_rate(rate_per_sec);
+    }
+
+    double rate() const {
+        return static_cast<double>(rate_units_.load(std::memory_order_relaxed)) / UNIT;
+    }
+
+private:
+    static uint64_t to_capacity(double burst_tokens) {
+        return std::min<uint64_t>(static_cast<uint64_t>(std::max(1.0, burst_tokens) * UNIT), TOKEN_MASK);
+    }
+
+    // Credits whole units for the elapsed time and advances the timestamp only
+    // by the time those units account for, so frequent callers lose nothing
+    // to rounding. Returns the credit that did not fit under capacity.
+    uint64_t refill(uint64_t now_us, uint64_t& last_us, uint64_t& units) const {
+        uint64_t elapsed = (now_us - last_us) & TIME_MASK;
+        if (elapsed > (TIME_MASK >> 1)) return 0; // Another thread stamped a later time
+        uint64_t rate = rate_units_.load(std::memory_order_relaxed);
+        if (rate == 0) return 0;
+        uint64_t capacity = capacity_units_.load(std::memory_order_relaxed);
+        uint64_t credit = elapsed * rate / 1'000'000;
+        if (units + credit >= capacity) {
+            uint64_t overflow = units + credit - capacity;
+            units = capacity;
+            last_us = now_us;
+            return overflow;
+        }
+        if (credit > 0) {
+            units += credit;
+            last_us = (last_us + credit * 1'000'000 / rate) & TIME_MASK;
+        }
+        return 0;
+    }
+};
+
+// Lock-free admission controller, safe from any number of submitters and
+// workers:
+//   - AtomicTokenBucket for the admission itself (one CAS per decision).
+//   - EWMA (alpha 1/8) of end-to-end latency, O(1) per completion.
+//   - CoDel-style control on sojourn time (queue delay at dispatch): if the
+//     minimum sojourn over an interval stays above target, the rate is cut
+//     and the next interval shortened by interval/sqrt(count); once the
+//     minimum falls back under target the rate recovers additively.
+class AdaptiveAdmission {
+    const uint64_t max_rate_;
+    AtomicTokenBucket bucket_;
+
+    // Adaptation
+    uint64_t target_sojourn_ns_ = 5'000'000;   // 5ms (CoDel target)
+    uint64_t interval_ns_ = 100'000'000;       // 100ms (CoDel interval)
+    std::atomic<uint64_t> interval_end_ns_;
+    std::atomic<uint64_t> interval_min_sojourn_ns_{std::numeric_limits<uint64_t>::max()};
+    std::atomic<uint32_t> drop_count_{0};      // Consecutive intervals above target
+    std::atomic<uint64_t> throttle_events_{0};
+    std::atomic<uint64_t> latency_ewma_ns_{0};
+
+public:
+    AdaptiveAdmission(uint64_t rate_per_sec) 
+        : max_rate_(rate_per_sec),
+          bucket_(static_cast<double>(rate_per_sec), static_cast<double>(rate_per_sec)),
+          interval_end_ns_(sys::now_ns() + interval_ns_) {}
+
+    bool can_admit() {
+        return bucket_.try_take(1) == 1;
+    }
+
+    // Batch admission: one refill, grants min(n, whole tokens available).
+    size_t admit_n(size_t n) {
+        return bucket_.try_take(n, /*partial=*/true);
+    }
+
+    // Returns tokens for admissions a later stage (enqueue) turned down.
+    void refund(size_t n) { bucket_.deposit(n); }
+
+    // End-to-end latency estimate; informational, does not steer the rate.
+    void feedback_latency(uint64_t latency_ns) {
+        uint64_t cur = latency_ewma_ns_.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            next = cur == 0 ? latency_ns
+                            : cur - (cur >> 3) + (latency_ns >> 3);
+        } while (!latency_ewma_ns_.compare_exchange_weak(cur, next, std::memory_order_relaxed));
+    }
+
+    // Queue delay of a task at dispatch; drives the CoDel control law.
+    void feedback_sojourn(uint64_t sojourn_ns, uint64_t now_ns) {
+        uint64_t cur_min = interval_min_sojourn_ns_.load(std::memory_order_relaxed);
+        while (sojourn_ns < cur_min &&
+               !interval_min_sojourn_ns_.compare_exchange_weak(cur_min, sojourn_ns, std::memory_order_relaxed)) {}
+
+        uint64_t end = interval_end_ns_.load(std::memory_order_acquire);
+        if (now_ns < end) return;
+
+        // Interval over. The thread that advances the deadline evaluates it.
+        uint32_t count = drop_count_.load(std::memory_order_relaxed);
+        uint64_t next_len = interval_ns_;
+        if (count > 0) {
+            next_len = static_cast<uint64_t>(interval_ns_ / std::sqrt(static_cast<double>(count + 1)));
+        }
+        if (!interval_end_ns_.compare_exchange_strong(end, now_ns + next_len, std::memory_order_acq_rel)) return;
+
+        uint64_t min_sojourn = interval_min_sojourn_ns_.exchange(std::numeric_limits<uint64_t>::max(),
+                                                                 std::memory_order_relaxed);
+        double rate = bucket_.rate();
+        if (min_sojourn > target_sojourn_ns_) {
+            // Standing queue: even the best-case wait exceeded target
+            drop_count_.store(count + 1, std::memory_order_relaxed);
+            throttle_events_.fetch_add(1, std::memory_order_relaxed);
+            bucket_.set_rate(std::max(10.0, rate * 0.9));
+        } else {
+            drop_count_.store(0, std::memory_order_relaxed);
+            bucket_.set_rate(std::min(static_cast<double>(max_rate_), rate + max_rate_ * 0.05));
+        }
+    }
+
+    double current_rate() const { return bucket_.rate(); }
+    uint64_t latency_estimate_ns() const { return latency_ewma_ns_.load(std::memory_order_relaxed); }
+    uint64_t throttle_events() const { return throttle_events_.load(std::memory_order_relaxed); }
+};
+
+// Per-tenant admission isolation. Each tenant owns a token bucket refilled at
+// its weight's share of the reserved rate; a shared burst pool (its own
+// reserved slice plus whatever full tenant buckets spill, i.e. headroom idle
+// tenants are not using) lends to tenants whose bucket is empty. Idle tenants
+// never touch their bucket, so a borrower that finds the pool dry harvests
+// the overflow of a few other buckets first. A flooding tenant exhausts its
+// own bucket and its pool borrowing, never anyone else's reservation.
+//
+// Lookup is a fixed-capacity open-addressed table (insert-only, linear
+// probing), so the admission path takes no locks; registration serializes on
+// reg_mtx_ to re-split rates.
+class TenantAdmission {
+public:
+    struct Budget {
+        uint64_t id;
+        std::atomic<uint64_t> weight;       // Re-weighted under reg_mtx_, read lock-free
+        AtomicTokenBucket bucket;
+        std::atomic<uint64_t> admitted{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> borrowed{0}; // Admissions funded by the burst pool
+        std::atomic<uint32_t> home_node{0}; // Placement hint, read lock-free on submit/dispatch
+        TenantMetrics* live{nullptr};       // Scheduler-owned; fixed at first registration
+
+        Budget(uint64_t tenant, uint64_t w) : id(tenant), weight(w), bucket(0.0, 1.0) {}
+    };
+
+    enum class Grant : uint8_t { OWN, POOL, REJECTED };
+
+private:
+    static constexpr size_t TABLE_SIZE = 4096; // Power of two; max tenants
+    static constexpr uint64_t EMPTY = std::numeric_limits<uint64_t>::max();
+    static constexpr double POOL_SHARE = 0.2;  // Fraction of rate reserved for the pool
+    static constexpr double BURST_SECONDS = 0.25;
+    static constexpr size_t HARVEST_PROBES = 4; // Buckets swept per dry-pool miss
+
+    std::array<std::atomic<uint64_t>, TABLE_SIZE> keys_;
+    std::array<std::atomic<Budget*>, TABLE_SIZE> slots_{};
+    std::array<std::atomic<Budget*>, TABLE_SIZE> dense_{}; // Registration order, for harvesting
+    std::atomic<size_t> dense_count_{0};
+    std::atomic<size_t> harvest_cursor_{0};
+    std::vector<std::unique_ptr<Budget>> budgets_; // Owns entries; guarded by reg_mtx_
+    std::mutex reg_mtx_;
+
+    const double total_rate_;
+    uint64_t total_weight_{0};
+    AtomicTokenBucket pool_;
+
+public:
+    explicit TenantAdmission(uint64_t rate_per_sec)
+        : total_rate_(static_cast<double>(rate_per_sec)),
+          pool_(rate_per_sec * POOL_SHARE, rate_per_sec * BURST_SECONDS) {
+        for (auto& k : keys_) k.store(EMPTY, std::memory_order_relaxed);
+    }
+
+    // Registers or re-weights a tenant and re-splits the reserved rate.
+    bool register_tenant(uint64_t id, uint64_t weight, uint32_t home_node = 0, TenantMetrics* live = nullptr) {
+        std::lock_guard lk(reg_mtx_);
+        Budget* b = find(id);
+        if (b) {
+            total_weight_ -= b->weight.load(std::memory_order_relaxed);
+            b->weight.store(weight, std::memory_order_relaxed);
+            b->home_node.store(home_node, std::memory_order_relaxed);
+        } else {
+            size_t slot = probe(id);
+            if (slot == TABLE_SIZE) return false; // Table full
+            budgets_.push_back(std::make_unique<Budget>(id, weight));
+            b = budgets_.back().get();
+            b->home_node.store(home_node, std::memory_order_relaxed); // Published below
+            b->live = live;
+            // Slot before key: a find() that acquires the key must see the slot
+            slots_[slot].store(b, std::memory_order_relaxed);
+            keys_[slot].store(id, std::memory_order_release);
+            size_t n = dense_count_.load(std::memory_order_relaxed);
+            dense_[n].store(b, std::memory_order_release);
+            dense_count_.store(n + 1, std::memory_order_release);
+        }
+        total_weight_ += weight;
+
+        double reserved = total_rate_ * (1.0 - POOL_SHARE);
+        for (auto& budget : budgets_) {
+            double rate = total_weight_ ? reserved * budget->weight.load(std::memory_order_relaxed) / total_weight_ : 0.0;
+            budget->bucket.set_rate(rate, rate * BURST_SECONDS);
+        }
+        return true;
+    }
+
+    // Lock-free enumeration in registration order.
+    size_t tenant_count() const { return dense_count_.load(std::memory_order_acquire); }
+    const Budget& tenant_at(size_t i) const { return *dense_[i].load(std::memory_order_acquire); }
+
+    // Lock-free; nullptr if the tenant is not registered.
+    Budget* find(uint64_t id) const {
+        size_t i = slot_of(id);
+        for (size_t n = 0; n < TABLE_SIZE; ++n, i = (i + 1) & (TABLE_SIZE - 1)) {
+            uint64_t k = keys_[i].load(std::memory_order_acquire);
+            if (k == id) return slots_[i].load(std::memory_order_acquire);
+            if (k == EMPTY) return nullptr;
+        }
+        return nullptr;
+    }
+
+    Grant try_admit(Budget& b) {
+        uint64_t spilled = 0;
+        if (b.bucket.try_take(1, false, &spilled) == 1) {
+            pool_.deposit(spilled);
+            b.admitted.fetch_add(1, std::memory_order_relaxed);
+            return Grant::OWN;
+        }
+        if (pool_.try_take(1) == 1 || (harvest(b) && pool_.try_take(1) == 1)) {
+            b.admitted.fetch_add(1, std::memory_order_relaxed);
+            b.borrowed.fetch_add(1, std::memory_order_relaxed);
+            return Grant::POOL;
+        }
+        b.rejected.fetch_add(1, std::memory_order_relaxed);
+        return Grant::REJECTED;
+    }
+
+    // Undo a grant that a later stage (global admission) turned down.
+    void refund(Budget& b, Grant g) {
+        if (g == Grant::REJECTED) return;
+        (g == Grant::OWN ? b.bucket : pool_).deposit(1);
+        b.admitted.fetch_sub(1, std::memory_order_relaxed);
+        if (g == Grant::POOL) b.borrowed.fetch_sub(1, std::memory_order_relaxed);
+        b.rejected.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void reject(Budget& b) { b.rejected.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    // Refill a few other tenants' buckets so their overflow reaches the pool.
+    // Only credit above a bucket's capacity moves; reservations are untouched.
+    bool harvest(const Budget& self) {
+        size_t count = dense_count_.load(std::memory_order_acquire);
+        uint64_t total = 0;
+        for (size_t k = 0; k < std::min(HARVEST_PROBES, count); ++k) {
+            size_t i = harvest_cursor_.fetch_add(1, std::memory_order_relaxed) % count;
+            Budget* other = dense_[i].load(std::memory_order_acquire);
+            if (!other || other == &self) continue;
+            uint64_t spilled = 0;
+            other->bucket.try_take(0, false, &spilled);
+            total += spilled;
+        }
+        pool_.deposit(total);
+        return total > 0;
+    }
+
+    static size_t slot_of(uint64_t id) {
+        return static_cast<size_t>((id * 0x9e3779b97f4a7c15ull) >> 52) & (TABLE_SIZE - 1);
+    }
+
+    size_t probe(uint64_t id) const {
+        size_t i = slot_of(id);
+        for (size_t n = 0; n < TABLE_SIZE; ++n, i = (i + 1) & (TABLE_SIZE - 1)) {
+            if (keys_[i].load(std::memory_order_relaxed) == EMPTY) return i;
+        }
+        return TABLE_SIZE;
+    }
+};
+
+// ----------------------- Tenant Logic (HWFQ) ---------------------------------
+
+// How a dispatched task is charged to its tenant's vruntime.
+enum class VruntimeAccounting : uint8_t {
+    ESTIMATED, // Charge estimated_cost_ns at dispatch (scheduling-time guess)
+    MEASURED   // Charge the estimate at dispatch, then correct to finish - start
+};
+
+// How the next tenant is chosen from the runnable set.
+enum class TenantPicker : uint8_t {
+    MIN_VRUNTIME, // CFS: lowest vruntime
+    EEVDF         // Earliest virtual deadline among tenants with non-negative lag
+};
+
+// Weights are fixed-point with NICE_0_WEIGHT as 1.0: a tenant of that weight
+// advances vruntime at wall-clock rate, heavier tenants proportionally slower.
+inline constexpr uint64_t NICE_0_WEIGHT = 1024;
+
+// Delta vruntime = ns * (NICE_0_WEIGHT / weight), multiplied before dividing
+// so weights above NICE_0_WEIGHT, or not dividing it, are charged exactly.
+// Error is below 1ns of virtual time per charge.
+inline uint64_t vtime_delta(uint64_t ns, uint64_t weight) {
+    return ns * NICE_0_WEIGHT / std::max<uint64_t>(weight, 1);
+}
+
+struct TenantState {
+    uint64_t id;
+    uint64_t weight;     // For Weighted Fair Queuing
+    uint64_t vruntime;   // Virtual Runtime
+    
+    // Per-tenant queues by priority (intrusive lists of pool slots)
+    std::array<TaskList, 4> queues;
+
+    // Bit p set <=> queues[p] non-empty; lowest set bit is the next class to run
+    uint8_t nonempty_mask{0};
+    // Slot in the runnable index (NOT_RUNNABLE when no task is queued)
+    size_t heap_index{NOT_RUNNABLE};
+    // EEVDF: slot in the eligible index, and the virtual deadline of the head
+    // task (vruntime + its cost in virtual time)
+    size_t eligible_index{NOT_RUNNABLE};
+    uint64_t vdeadline{0};
+
+    // Metrics
+    uint64_t executed_ns{0};
+    TenantMetrics* live{nullptr}; // Lock-free mirror read by snapshots; may be null
+
+    static constexpr size_t NOT_RUNNABLE = std::numeric_limits<size_t>::max();
+
+    bool runnable() const { return nonempty_mask != 0; }
+};
+
+// Intrusive indexed binary min-heap of tenants. Each tenant stores its own
+// slot (via Slot) so an arbitrary tenant can be re-keyed or removed in
+// O(log n) without a search. Holds runnable tenants only.
+template<size_t TenantState::*Slot, typename Less>
+class TenantHeap {
+    std::vector<TenantState*> heap_;
+
+public:
+    void reserve(size_t n) { heap_.reserve(n); }
+    bool empty() const { return heap_.empty(); }
+    size_t size() const { return heap_.size(); }
+    TenantState* top() const { return heap_.front(); }
+    TenantState* at(size_t i) const { return heap_[i]; }
+
+    void push(TenantState* t) {
+        t->*Slot = heap_.size();
+        heap_.push_back(t);
+        sift_up(t->*Slot);
+    }
+
+    void erase(TenantState* t) {
+        size_t i = t->*Slot;
+        t->*Slot = TenantState::NOT_RUNNABLE;
+        TenantState* last = heap_.back();
+        heap_.pop_back();
+        if (i == heap_.size()) return;
+        place(i, last);
+        update_at(i);
+    }
+
+    // Restore heap order after t's key changed in either direction.
+    void update(TenantState* t) { update_at(t->*Slot); }
+
+private:
+    void place(size_t i, TenantState* t) {
+        heap_[i] = t;
+        t->*Slot = i;
+    }
+
+    void update_at(size_t i) {
+        if (i > 0 && Less{}(heap_[i], heap_[(i - 1) / 2])) sift_up(i);
+        else sift_down(i);
+    }
+
+    void sift_up(size_t i) {
+        TenantState* t = heap_[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!Less{}(t, heap_[parent])) break;
+            place(i, heap_[parent]);
+            i = parent;
+        }
+        place(i, t);
+    }
+
+    void sift_down(size_t i) {
+        TenantState* t = heap_[i];
+        const size_t n = heap_.size();
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && Less{}(heap_[child + 1], heap_[child])) ++child;
+            if (!Less{}(heap_[child], t)) break;
+            place(i, heap_[child]);
+            i = child;
+        }
+        place(i, t);
+    }
+};
+
+// Ties broken by tenant id, matching the old ordered-map scan.
+struct ByVruntime {
+    bool operator()(const TenantState* a, const TenantState* b) const {
+        return a->vruntime != b->vruntime ? a->vruntime < b->vruntime : a->id < b->id;
+    }
+};
+
+struct ByDeadline {
+    bool operator()(const TenantState* a, const TenantState* b) const {
+        return a->vdeadline != b->vdeadline ? a->vdeadline < b->vdeadline : a->id < b->id;
+    }
+};
+
+// HWFQ run queue: tenant lanes ordered by vruntime, priority queues within a
+// tenant. Not synchronized; the owner (global queue or core shard) holds the
+// lock. Every run queue carries a lane for every registered tenant so tasks
+// can migrate between shards without re-registration. Tasks stay in their
+// TaskPool slot; all run queues of a scheduler share one pool, so a
+// migration is a relink.
+//
+// Only runnable tenants sit in the vruntime index, so idle tenants cost
+// nothing per dispatch: selection is the heap top, the priority class is the
+// lowest bit of nonempty_mask, and the re-key after charging is O(log n).
+//
+// EEVDF splits the runnable tenants across two indexes: eligible_ (vruntime
+// at or below the weighted average V, ordered by virtual deadline) and
+// runnable_ (the rest, ordered by vruntime). Each pick first migrates
+// tenants that became eligible from the top of runnable_, so both stay
+// O(log n). A tenant whose head task is small gets an early deadline and is
+// dispatched within about one slice of becoming eligible, while eligibility
+// keeps it from running ahead of its weighted share.
+class TenantRunQueue {
+    TaskPool& pool_;
+    const uint32_t tag_; // Recorded in each queued slot (TaskPool::queue_of)
+    std::map<uint64_t, TenantState> tenants_;
+    TenantHeap<&TenantState::heap_index, ByVruntime> runnable_;
+    TenantHeap<&TenantState::eligible_index, ByDeadline> eligible_;
+    TenantPicker picker_;
+    size_t queued_{0};
+
+    // EEVDF weighted average: V = avg_base_ + avg_sum_ / avg_weight_, where
+    // avg_sum_ = sum(weight * (vruntime - avg_base_)) over runnable tenants.
+    // Keys are relative to a base that follows V, so the sum stays small.
+    uint64_t avg_base_{0};
+    int64_t avg_sum_{0};
+    uint64_t avg_weight_{0};
+
+public:
+    explicit TenantRunQueue(TaskPool& pool, TenantPicker picker = TenantPicker::MIN_VRUNTIME, uint32_t tag = 0)
+        : pool_(pool), tag_(tag), picker_(picker) {}
+
+    void add_tenant(uint64_t id, uint64_t weight, TenantMetrics* live = nullptr) {
+        auto [it, inserted] = tenants_.try_emplace(id, TenantState{id, weight, 0, {}});
+        if (!inserted) {
+            // Re-registration resets accounting; drop the lane from the index
+            // and return its queued tasks to the pool first
+            if (it->second.runnable()) {
+                queued_ -= lane_size(it->second);
+                dequeue_tenant(it->second);
+                for (size_t p = 0; p < it->second.queues.size(); ++p) {
+                    auto& q = it->second.queues[p];
+                    mirror_depth(it->second, p, -static_cast<int64_t>(q.size()));
+                    while (!q.empty()) {
+                        TaskRef ref = q.pop_front(pool_);
+                        pool_.set_queue(ref, TaskPool::NOT_QUEUED);
+                        pool_.release(ref);
+                    }
+                }
+            }
+            it->second = TenantState{id, weight, 0, {}};
+        }
+        it->second.live = live;
+        runnable_.reserve(tenants_.size());
+        eligible_.reserve(tenants_.size());
+    }
+
+    bool has_tenant(uint64_t id) const { return tenants_.contains(id); }
+
+    // Returns false if the tenant is unknown to this queue.
+    bool push(TaskRef ref) {
+        const Task& t = pool_[ref];
+        auto it = tenants_.find(t.tenant_id);
+        if (it == tenants_.end()) return false;
+        size_t p = static_cast<size_t>(t.current_priority);
+        it->second.queues[p].push_back(pool_, ref);
+        pool_.set_queue(ref, tag_);
+        mark_queued(it->second, p);
+        return true;
+    }
+
+    // Re-queue at the head of its priority class (blocked on a resource).
+    void push_front(TaskRef ref) {
+        const Task& t = pool_[ref];
+        TenantState& tenant = tenants_[t.tenant_id];
+        size_t p = static_cast<size_t>(t.current_priority);
+        tenant.queues[p].push_front(pool_, ref);
+        pool_.set_queue(ref, tag_);
+        mark_queued(tenant, p);
+    }
+
+    // Priority inheritance on a queued task: move it to the head of class
+    // `prio` if that is more urgent. The tenant stays runnable throughout.
+    // Returns false if the task was already at least that urgent.
+    bool boost(TaskRef ref, Priority prio) {
+        Task& t = pool_[ref];
+        size_t from = static_cast<size_t>(t.current_priority);
+        size_t to = static_cast<size_t>(prio);
+        if (to >= from) return false;
+        auto it = tenants_.find(t.tenant_id);
+        if (it == tenants_.end()) return false;
+        TenantState& tenant = it->second;
+
+        tenant.queues[from].erase(pool_, ref);
+        mirror_depth(tenant, from, -1);
+        if (tenant.queues[from].empty()) tenant.nonempty_mask &= static_cast<uint8_t>(~(1u << from));
+        t.current_priority = prio;
+        tenant.queues[to].push_front(pool_, ref);
+        mirror_depth(tenant, to, 1);
+        tenant.nonempty_mask |= static_cast<uint8_t>(1u << to);
+        refresh_deadline(tenant); // New head task
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    // SCHEDULING ALGORITHM: Hierarchical Weighted Fair Queuing
+    // ---------------------------------------------------------
+    // 1. Select Tenant: lowest Virtual Runtime (CFS-style) or, with EEVDF,
+    //    earliest virtual deadline among eligible tenants
+    // 2. Select highest priority task within Tenant
+    // Returns NO_TASK when empty.
+    TaskRef pop_next() {
+        TenantState* best_tenant = (picker_ == TenantPicker::EEVDF)
+            ? pick_eevdf()
+            : (runnable_.empty() ? nullptr : runnable_.top());
+        if (!best_tenant) return NO_TASK;
+
+        TaskRef ref = take_front(*best_tenant, std::countr_zero(best_tenant->nonempty_mask));
+
+        // Penalize tenant vruntime with the estimate; MEASURED accounting
+        // corrects it through complete() once the run time is known.
+        charge(*best_tenant, static_cast<int64_t>(vtime_delta(pool_[ref].estimated_cost_ns, best_tenant->weight)));
+        return ref;
+    }
+
+    // Move up to max_tasks into dst, one task per tenant per pass so a steal
+    // does not strip a single tenant. Takes from the head of the highest
+    // priority queues: the thief is idle now, the victim is mid-task. Vruntime
+    // is charged by whichever queue finally dispatches the task.
+    size_t steal_into(TenantRunQueue& dst, size_t max_tasks) {
+        size_t moved = 0;
+        while (moved < max_tasks && queued_ > 0) {
+            // One pass over both indexes. take_front() may erase the current
+            // slot, in which case another tenant moves into it.
+            for (size_t i = 0; i < runnable_.size() + eligible_.size() && moved < max_tasks; ) {
+                TenantState* tenant = i < runnable_.size() ? runnable_.at(i) : eligible_.at(i - runnable_.size());
+                dst.push(take_front(*tenant, std::countr_zero(tenant->nonempty_mask)));
+                ++moved;
+                if (tenant->runnable()) ++i;
+            }
+        }
+        return moved;
+    }
+
+    // Record a finished task. measured_ns is what it actually ran; under
+    // MEASURED accounting the estimate charged at dispatch is replaced by it.
+    void complete(uint64_t tenant_id, uint64_t estimated_ns, uint64_t measured_ns, VruntimeAccounting mode) {
+        auto it = tenants_.find(tenant_id);
+        if (it == tenants_.end()) return;
+        TenantState& tenant = it->second;
+        tenant.executed_ns += measured_ns;
+        if (tenant.live) tenant.live->executed_ns.fetch_add(measured_ns, std::memory_order_relaxed);
+        if (mode == VruntimeAccounting::MEASURED) {
+            charge(tenant, static_cast<int64_t>(vtime_delta(measured_ns, tenant.weight)) -
+                           static_cast<int64_t>(vtime_delta(estimated_ns, tenant.weight)));
+        }
+    }
+
+    size_t size() const { return queued_; }
+    bool empty() const { return queued_ == 0; }
+    const std::map<uint64_t, TenantState>& tenants() const { return tenants_; }
+
+private:
+    void mark_queued(TenantState& tenant, size_t p) {
+        bool was_runnable = tenant.runnable();
+        tenant.nonempty_mask |= static_cast<uint8_t>(1u << p);
+        ++queued_;
+        mirror_depth(tenant, p, 1);
+        if (!was_runnable) enqueue_tenant(tenant);
+        else if (p == static_cast<size_t>(std::countr_zero(tenant.nonempty_mask))) refresh_deadline(tenant);
+    }
+
+    static void mirror_depth(TenantState& tenant, size_t p, int64_t delta) {
+        if (tenant.live) tenant.live->depth[p].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    // Pops the head of queues[p]; drops the tenant from the index when drained.
+    TaskRef take_front(TenantState& tenant, size_t p) {
+        auto& q = tenant.queues[p];
+        TaskRef ref = q.pop_front(pool_);
+        pool_.set_queue(ref, TaskPool::NOT_QUEUED);
+        --queued_;
+        mirror_depth(tenant, p, -1);
+        if (q.empty()) tenant.nonempty_mask &= static_cast<uint8_t>(~(1u << p));
+        if (!tenant.runnable()) dequeue_tenant(tenant);
+        else refresh_deadline(tenant); // New head task
+        return ref;
+    }
+
+    void enqueue_tenant(TenantState& tenant) {
+        if (picker_ == TenantPicker::EEVDF) {
+            // A tenant waking from idle starts at V: lag accrued while it had
+            // nothing queued is not banked against the tenants that kept running.
+            // The live mirror takes the same step, so snapshots see the placed
+            // vruntime instead of reporting the forgiven lag.
+            if (avg_weight_ > 0) {
+                uint64_t placed = std::max(tenant.vruntime, avg_vruntime());
+                if (tenant.live) tenant.live->vruntime.fetch_add(placed - tenant.vruntime, std::memory_order_relaxed);
+                tenant.vruntime = placed;
+            }
+            avg_add(tenant);
+            refresh_deadline(tenant);
+        }
+        runnable_.push(&tenant);
+    }
+
+    void dequeue_tenant(TenantState& tenant) {
+        if (tenant.eligible_index != TenantState::NOT_RUNNABLE) eligible_.erase(&tenant);
+        else runnable_.erase(&tenant);
+        if (picker_ == TenantPicker::EEVDF) avg_remove(tenant);
+    }
+
+    // Apply a (possibly negative) vruntime delta and restore index order.
+    void charge(TenantState& tenant, int64_t delta) {
+        if (delta < 0 && static_cast<uint64_t>(-delta) > tenant.vruntime) {
+            delta = -static_cast<int64_t>(tenant.vruntime);
+        }
+        tenant.vruntime += static_cast<uint64_t>(delta);
+        if (tenant.live) tenant.live->vruntime.fetch_add(static_cast<uint64_t>(delta), std::memory_order_relaxed);
+        if (!tenant.runnable()) return;
+
+        if (picker_ != TenantPicker::EEVDF) {
+            runnable_.update(&tenant);
+            return;
+        }
+        avg_sum_ += delta * static_cast<int64_t>(tenant.weight);
+        refresh_deadline(tenant);
+        // Eligibility may have changed; the next pick re-migrates it if not
+        if (tenant.eligible_index != TenantState::NOT_RUNNABLE) {
+            eligible_.erase(&tenant);
+            runnable_.push(&tenant);
+        } else {
+            runnable_.update(&tenant);
+        }
+    }
+
+    void refresh_deadline(TenantState& tenant) {
+        if (picker_ != TenantPicker::EEVDF || !tenant.runnable()) return;
+        const Task& head = pool_[tenant.queues[std::countr_zero(tenant.nonempty_mask)].front()];
+        tenant.vdeadline = tenant.vruntime + vtime_delta(head.estimated_cost_ns, tenant.weight);
+        if (tenant.eligible_index != TenantState::NOT_RUNNABLE) eligible_.update(&tenant);
+    }
+
+    TenantState* pick_eevdf() {
+        if (avg_weight_ == 0) return nullptr;
+
+        // Re-center the keys on V
+        int64_t shift = avg_sum_ / static_cast<int64_t>(avg_weight_);
+        avg_base_ += static_cast<uint64_t>(shift);
+        avg_sum_ -= shift * static_cast<int64_t>(avg_weight_);
+
+        while (!runnable_.empty() && eligible(*runnable_.top())) {
+            TenantState* t = runnable_.top();
+            runnable_.erase(t);
+            eligible_.push(t);
+        }
+        // V can move backwards when a tenant leaves; demote stale entries lazily
+        while (!eligible_.empty() && !eligible(*eligible_.top())) {
+            TenantState* t = eligible_.top();
+            eligible_.erase(t);
+            runnable_.push(t);
+        }
+        // The minimum vruntime is always <= V, so eligible_ is non-empty here
+        return eligible_.empty() ? runnable_.top() : eligible_.top();
+    }
+
+    int64_t avg_key(const TenantState& t) const { return static_cast<int64_t>(t.vruntime - avg_base_); }
+
+    // vruntime <= V, compared without dividing
+    bool eligible(const TenantState& t) const {
+        return avg_key(t) * static_cast<int64_t>(avg_weight_) <= avg_sum_;
+    }
+
+    // Rounded down, so a tenant placed at V is eligible
+    uint64_t avg_vruntime() const {
+        int64_t w = static_cast<int64_t>(avg_weight_);
+        int64_t q = avg_sum_ / w;
+        if (avg_sum_ % w < 0) --q;
+        return avg_base_ + static_cast<uint64_t>(q);
+    }
+
+    void avg_add(const TenantState& t) {
+        if (avg_weight_ == 0) {
+            avg_base_ = t.vruntime;
+            avg_sum_ = 0;
+        }
+        avg_sum_ += avg_key(t) * static_cast<int64_t>(t.weight);
+        avg_weight_ += t.weight;
+    }
+
+    void avg_remove(const TenantState& t) {
+        avg_sum_ -= avg_key(t) * static_cast<int64_t>(t.weight);
+        avg_weight_ -= t.weight;
+    }
+
+    static size_t lane_size(const TenantState& t) {
+        size_t n = 0;
+        for (const auto& q : t.queues) n += q.size();
+        return n;
+    }
+};
+
+// --------------------------- The Core Scheduler ------------------------------
+
+// One entry of a submit_batch() call; mirrors submit()'s parameters.
+struct SubmitRequest {
+    uint64_t tenant_id;
+    Priority prio;
+    uint64_t cost_ns;
+    uint64_t deadline_offset_ns;
+    uint32_t resource_need{0};
+    uint32_t nested_resource_need{0};
+};
+
+using SubmitResult = std::expected<void, std::string>;
+
+enum class DispatchMode : uint8_t {
+    GLOBAL,  // Single run queue behind one lock (reference model)
+    SHARDED  // Per-core run queues, idle cores steal batches from busy ones
+};
+
+enum class ExecutionModel : uint8_t {
+    THREADED, // One thread per core, task cost spent in a busy wait
+    VIRTUAL   // No threads: cores are slots in a discrete-event loop on sys::VirtualClock
+};
+
+class HierarchicalScheduler {
+public:
+    struct Config {
+        size_t cores = 4;
+        uint64_t base_rate = 2000; // Admission tokens/sec
+        DispatchMode mode = DispatchMode::GLOBAL;
+        ExecutionModel execution = ExecutionModel::THREADED;
+        size_t num_resources = 16; // Simulated locks, ids 1..num_resources
+        uint32_t task_capacity = 1 << 16; // Queued + parked + running tasks; bounds memory
+        VruntimeAccounting accounting = VruntimeAccounting::ESTIMATED;
+        TenantPicker picker = TenantPicker::MIN_VRUNTIME;
+        // Pin workers to CPUs and keep each tenant's work on its home node's
+        // shards (SHARDED), stealing across nodes only when the node is dry.
+        bool numa_aware = false;
+        size_t numa_nodes = 0; // 0: read /sys topology; N: model N equal nodes (never pinned)
+        // Invoked on the worker thread after each completed task (benchmarks)
+        std::function<void(size_t core_id, const Task&)> on_complete{};
+    };
+
+private:
+    // Written only by the owning worker; padded so neighbours do not share a line
+    struct alignas(64) CoreStats {
+        uint64_t tasks_run{0};
+        uint64_t idle_ns{0};
+        uint64_t dispatched{0};   // Tasks popped for execution on this core
+        uint64_t steals{0};       // Successful steal operations
+        uint64_t stolen_tasks{0}; // Tasks migrated in by those steals
+        uint64_t remote_dispatches{0}; // Dispatched tasks whose tenant lives on another node
+        uint64_t remote_steals{0};     // Steals from a shard on another node
+    };
+
+    // One run queue with its lock and wakeup. GLOBAL mode has exactly one,
+    // shared by every worker; SHARDED mode has one per core.
+    struct alignas(64) CoreShard {
+        std::mutex mtx;
+        std::condition_variable cv;
+        TenantRunQueue rq;
+        std::atomic<size_t> depth{0}; // Advisory mirror of rq.size() for victim selection
+        std::atomic<uint32_t> sleepers{0}; // Workers parked on cv (modified under mtx)
+        const size_t index;                // == home core in SHARDED mode
+
+        CoreShard(size_t i, TaskPool& pool, TenantPicker picker) : rq(pool, picker, static_cast<uint32_t>(i)), index(i) {}
+    };
+
+    // VIRTUAL execution: completion of the task running on `core`
+    struct VirtualEvent {
+        uint64_t at;
+        size_t core;
+        bool operator>(const VirtualEvent& o) const { return at != o.at ? at > o.at : core > o.core; }
+    };
+
+    static constexpr size_t STEAL_BATCH = 32;
+    static constexpr sys::Micro STEAL_POLL_MIN{200};    // First idle re-check after running a task
+    static constexpr sys::Micro STEAL_POLL_MAX{10'000}; // Backoff ceiling for a long-idle core
+    static constexpr size_t NOT_IDLE = std::numeric_limits<size_t>::max();
+    static constexpr size_t MAX_CORE_LINES = 16; // Per-core rows in print_stats()
+
+public:
+    struct PlacementStats {
+        size_t nodes{0};
+        size_t pinned_workers{0};
+        uint64_t dispatched{0};
+        uint64_t remote_dispatches{0};
+        uint64_t steals{0};
+        uint64_t remote_steals{0};
+    };
+
+private:
+
+    // Configuration
+    const size_t num_cores_;
+    const DispatchMode mode_;
+    const ExecutionModel execution_; // Initialized before any component reads the clock
+    const VruntimeAccounting accounting_;
+    const TenantPicker picker_;
+    const std::function<void(size_t, const Task&)> on_complete_;
+    const bool numa_aware_;
+    std::atomic<bool> running_{true};
+
+    // Placement. Nodes are the topology's nodes that received at least one
+    // core; cores take CPUs in node order, spread evenly over all online CPUs.
+    sys::CpuTopology topology_;
+    std::vector<uint32_t> core_node_;              // Per core
+    std::vector<int> core_cpu_;                    // Per core; -1 = not pinned
+    std::vector<std::vector<size_t>> node_shards_; // SHARDED: shard (== core) ids per node
+    std::vector<std::vector<size_t>> wake_order_;  // Per node: shards to wake, local first
+    struct TenantHome {
+        uint32_t node;
+        uint64_t weight;
+        std::unique_ptr<TenantMetrics> live; // Stable address, shared with queues and admission
+    };
+    std::vector<uint64_t> node_weight_;            // Tenant weight homed per node
+    std::map<uint64_t, TenantHome> tenant_home_;
+    std::mutex placement_mtx_;                     // Guards node_weight_, tenant_home_
+    std::atomic<size_t> pinned_workers_{0};
+    
+    // Components
+    TaskPool pool_; // Outlives everything that links its slots
+    ResourceManager resource_mgr_;
+    AdaptiveAdmission admission_;
+    TenantAdmission tenant_admission_;
+    sys::Random rng_;
+
+    // Run queues (each protected by its own shard mutex)
+    std::vector<std::unique_ptr<CoreShard>> shards_;
+    std::atomic<size_t> next_shard_{0};
+    
+    // Thread Pool
+    std::vector<std::jthread> workers_;
+    std::vector<CoreStats> worker_stats_;
+    std::vector<sys::Random> core_rng_; // Per-core, so execution jitter needs no lock
+
+    // VIRTUAL execution (driver thread only)
+    std::priority_queue<VirtualEvent, std::vector<VirtualEvent>, std::greater<>> events_;
+    std::vector<TaskRef> running_tasks_;             // Per core
+    std::vector<std::vector<size_t>> idle_cores_;    // Stack of idle cores per node (one group unless NUMA-aware)
+    std::vector<size_t> idle_slot_;                  // Per core: position in its stack or NOT_IDLE
+    std::vector<uint64_t> idle_since_;
+    std::vector<std::pair<size_t, size_t>> pending_wakes_; // (shard, runnable) not yet dispatched
+
+    // Metrics
+    std::atomic<uint64_t> dropped_tasks_{0};
+    std::atomic<uint64_t> completed_tasks_{0};
+    std::atomic<uint64_t> deadline_misses_{0};
+    std::atomic<uint64_t> pi_events_{0}; // Priority Inheritance events
+    std::atomic<uint64_t> parked_tasks_{0}; // Tasks parked on a resource wait queue
+    std::atomic<uint64_t> pool_exhausted_{0}; // Submissions refused for lack of a task slot
+
+public:
+    explicit HierarchicalScheduler(Config cfg) 
+        : num_cores_(cfg.cores), 
+          mode_(cfg.mode),
+          execution_(enter_execution_model(cfg.execution)),
+          accounting_(cfg.accounting),
+          picker_(cfg.picker),
+          on_complete_(std::move(cfg.on_complete)),
+          numa_aware_(cfg.numa_aware),
+          topology_(cfg.numa_nodes ? sys::CpuTopology::synthetic(cfg.numa_nodes, cfg.cores)
+                                   : sys::CpuTopology::detect()),
+          pool_(cfg.task_capacity),
+          resource_mgr_(pool_, cfg.num_resources),
+          admission_(cfg.base_rate),
+          tenant_admission_(cfg.base_rate),
+          rng_(0xDEADBEEF),
+          worker_stats_(cfg.cores)
+    {
+        size_t n_shards = (mode_ == DispatchMode::SHARDED) ? num_cores_ : 1;
+        for (size_t i = 0; i < n_shards; ++i) {
+            shards_.push_back(std::make_unique<CoreShard>(i, pool_, picker_));
+        }
+        for (size_t i = 0; i < num_cores_; ++i) {
+            core_rng_.emplace_back(0xC0FFEE + i);
+        }
+        place_cores(numa_aware_ && topology_.from_sysfs && execution_ == ExecutionModel::THREADED);
+        if (execution_ == ExecutionModel::VIRTUAL) {
+            running_tasks_.assign(num_cores_, NO_TASK);
+            idle_cores_.resize(numa_aware_ ? node_shards_.size() : 1);
+            idle_slot_.assign(num_cores_, NOT_IDLE);
+            idle_since_.assign(num_cores_, 0);
+            for (size_t i = num_cores_; i-- > 0; ) set_idle(i); // Core 0 on top
+        }
+        // Initialize default tenant
+        register_tenant(0, 100); 
+    }
+
+    ~HierarchicalScheduler() {
+        if (execution_ == ExecutionModel::VIRTUAL) sys::VirtualClock::disable();
+    }
+
+    void start() {
+        telemetry::info("Starting Scheduler with {} cores ({} run queues)...", num_cores_, shards_.size());
+        if (execution_ == ExecutionModel::VIRTUAL) return; // Driven by advance_to()
+        for (size_t i = 0; i < num_cores_; ++i) {
+            workers_.emplace_back([this, i](std::stop_token st) {
+                this->worker_loop(i, st);
+            });
+        }
+    }
+
+    void register_tenant(uint64_t id, uint64_t weight) {
+        // Published to the lock-free admission table only once every run
+        // queue has a lane for it.
+        auto [node, live] = home_tenant(id, weight);
+        for (auto& shard : shards_) {
+            std::lock_guard lk(shard->mtx);
+            shard->rq.add_tenant(id, weight, live);
+        }
+        if (!tenant_admission_.register_tenant(id, weight, node, live)) {
+            telemetry::warn("Tenant table full; tenant {} cannot be admitted", id);
+        }
+        telemetry::info("Registered Tenant {} with weight {} on node {}", id, weight, node);
+    }
+
+    // Submission API: Returns expected<void, string> (C++23)
+    SubmitResult submit(
+        uint64_t tenant_id, 
+        Priority prio, 
+        uint64_t cost_ns, 
+        uint64_t deadline_offset_ns,
+        uint32_t resource_need = 0,
+        uint32_t nested_resource_need = 0
+    ) {
+        // 1. Admission Control: the tenant's own budget (or the shared burst
+        //    pool) first, so a flooding tenant cannot drain the global rate.
+        auto* budget = tenant_admission_.find(tenant_id);
+        if (!budget) {
+            return std::unexpected("Tenant not found");
+        }
+        // A slot first: refusing for lack of memory must not consume tokens
+        TaskRef ref = pool_.allocate();
+        if (ref == NO_TASK) {
+            pool_exhausted_++;
+            return std::unexpected("Task pool exhausted");
+        }
+        auto grant = tenant_admission_.try_admit(*budget);
+        if (grant == TenantAdmission::Grant::REJECTED) {
+            pool_.release(ref);
+            return std::unexpected("Tenant budget exhausted");
+        }
+        if (!admission_.can_admit()) {
+            tenant_admission_.refund(*budget, grant);
+            pool_.release(ref);
+            return std::unexpected("Global backpressure active");
+        }
+
+        pool_[ref] = make_task({tenant_id, prio, cost_ns, deadline_offset_ns, resource_need, nested_resource_need},
+                               sys::now_ns());
+
+        // 2. Placement: round-robin across shards (the tenant's home node's
+        //    when NUMA-aware), stealing rebalances.
+        CoreShard& shard = next_shard(budget->home_node.load(std::memory_order_relaxed));
+        bool queued;
+        {
+            std::lock_guard lk(shard.mtx);
+            queued = shard.rq.push(ref);
+            if (queued) shard.depth.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (!queued) {
+            tenant_admission_.refund(*budget, grant);
+            admission_.refund(1);
+            pool_.release(ref);
+            return std::unexpected("Tenant not found");
+        }
+        
+        wake_workers(shard, 1);
+        return {};
+    }
+
+    // Batch submission: per-tenant budgets are charged request by request
+    // (lock-free), then the survivors are admitted against the global bucket
+    // in one step, enqueued under one lock acquisition per home node (one in
+    // total unless NUMA-aware), and at most one worker is woken per new
+    // runnable task. Global admission grants a prefix of the survivors; the
+    // rest, and any the run queue refuses, are refunded and rejected.
+    // results[i] corresponds to reqs[i].
+    std::vector<SubmitResult> submit_batch(std::span<const SubmitRequest> reqs) {
+        std::vector<SubmitResult> results(reqs.size());
+        if (reqs.empty()) return results;
+
+        // 1. Admission Control
+        struct Pending {
+            size_t index;
+            TenantAdmission::Budget* budget;
+            TenantAdmission::Grant grant;
+            TaskRef ref;
+            uint32_t node;       // Home node, read once so a batch cannot split a tenant
+            bool queued = false;
+        };
+        std::vector<Pending> pending;
+        pending.reserve(reqs.size());
+        for (size_t i = 0; i < reqs.size(); ++i) {
+            auto* budget = tenant_admission_.find(reqs[i].tenant_id);
+            if (!budget) {
+                results[i] = std::unexpected("Tenant not found");
+                continue;
+            }
+            TaskRef ref = pool_.allocate();
+            if (ref == NO_TASK) {
+                pool_exhausted_++;
+                results[i] = std::unexpected("Task pool exhausted");
+                continue;
+            }
+            auto grant = tenant_admission_.try_admit(*budget);
+            if (grant == TenantAdmission::Grant::REJECTED) {
+                pool_.release(ref);
+                results[i] = std::unexpected("Tenant budget exhausted");
+                continue;
+            }
+            pending.push_back({i, budget, grant, ref, budget->home_node.load(std::memory_order_relaxed)});
+        }
+
+        size_t admitted = admission_.admit_n(pending.size());
+        for (size_t k = admitted; k < pending.size(); ++k) {
+            tenant_admission_.refund(*pending[k].budget, pending[k].grant);
+            pool_.release(pending[k].ref);
+            results[pending[k].index] = std::unexpected("Global backpressure active");
+        }
+        if (admitted == 0) return results;
+
+        // 2. Build in place, outside the lock
+        uint64_t now = sys::now_ns();
+        for (size_t k = 0; k < admitted; ++k) {
+            pool_[pending[k].ref] = make_task(reqs[pending[k].index], now);
+        }
+
+        // 3. Enqueue one group per home node, each under a single acquisition
+        //    of a shard on that node; stealing spreads it in SHARDED mode.
+        //    The sort is stable, so each tenant keeps its submission order.
+        bool by_node = numa_aware_ && mode_ == DispatchMode::SHARDED;
+        if (by_node) {
+            std::stable_sort(pending.begin(), pending.begin() + admitted,
+                             [](const Pending& a, const Pending& b) { return a.node < b.node; });
+        }
+        size_t refused = 0;
+        for (size_t begin = 0, end; begin < admitted; begin = end) {
+            for (end = begin + 1; end < admitted && (!by_node || pending[end].node == pending[begin].node); ++end) {}
+            CoreShard& shard = next_shard(pending[begin].node);
+            size_t enqueued = 0;
+            {
+                std::lock_guard lk(shard.mtx);
+                for (size_t k = begin; k < end; ++k) {
+                    pending[k].queued = shard.rq.push(pending[k].ref);
+                    enqueued += pending[k].queued;
+                }
+                shard.depth.fetch_add(enqueued, std::memory_order_relaxed);
+            }
+            wake_workers(shard, enqueued);
+            refused += (end - begin) - enqueued;
+        }
+
+        if (refused > 0) {
+            for (size_t k = 0; k < admitted; ++k) {
+                if (pending[k].queued) continue;
+                tenant_admission_.refund(*pending[k].budget, pending[k].grant);
+                pool_.release(pending[k].ref);
+                results[pending[k].index] = std::unexpected("Tenant not found");
+            }
+            admission_.refund(refused);
+        }
+        return results;
+    }
+
+    // VIRTUAL execution: run every completion due at or before t_ns, then move
+    // the clock to t_ns. Drivers call this before each submission.
+    void advance_to(uint64_t t_ns) {
+        flush_wakes();
+        while (!events_.empty() && events_.top().at <= t_ns) run_next_event();
+        sys::VirtualClock::advance_to(t_ns);
+    }
+
+    // VIRTUAL execution: run until nothing is running or queued. Returns the
+    // simulated time at which the last task finished.
+    uint64_t run_until_idle() {
+        flush_wakes();
+        while (!events_.empty()) run_next_event();
+        return sys::now_ns();
+    }
+
+    // Read once workers are joined (shutdown()) or from the VIRTUAL driver.
+    PlacementStats placement_stats() const {
+        PlacementStats ps{.nodes = node_shards_.size(), .pinned_workers = pinned_workers_.load()};
+        for (const auto& cs : worker_stats_) {
+            ps.dispatched += cs.dispatched;
+            ps.remote_dispatches += cs.remote_dispatches;
+            ps.steals += cs.steals;
+            ps.remote_steals += cs.remote_steals;
+        }
+        return ps;
+    }
+
+    // Live view for monitoring while running. Reads only atomics, so it never
+    // blocks a dispatch and is cheap enough to poll every 100ms (a few KB of
+    // relaxed loads per tenant). Lag compares each tenant's charged vruntime
+    // with the weighted mean over the backlogged tenants (over every tenant
+    // that has run, when none is), so it tracks fairness among tenants that
+    // compete and ignores ones that never ask for service.
+    SchedulerSnapshot snapshot() const {
+        SchedulerSnapshot snap{.taken_ns = sys::now_ns(), .completed = completed_tasks_.load(),
+                               .dropped = dropped_tasks_.load(), .deadline_misses = deadline_misses_.load(),
+                               .pool_in_use = pool_.in_use()};
+        size_t count = tenant_admission_.tenant_count();
+        snap.tenants.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            const auto& b = tenant_admission_.tenant_at(i);
+            if (!b.live) continue;
+            const TenantMetrics& m = *b.live;
+            auto& t = snap.tenants.emplace_back();
+            t.id = b.id;
+            t.weight = m.weight.load(std::memory_order_relaxed);
+            t.home_node = b.home_node.load(std::memory_order_relaxed);
+            for (size_t p = 0; p < t.depth.size(); ++p) {
+                // A steal decrements the victim before incrementing the thief
+                t.depth[p] = static_cast<uint64_t>(std::max<int64_t>(0, m.depth[p].load(std::memory_order_relaxed)));
+                snap.depth[p] += t.depth[p];
+            }
+            t.executed_ns = m.executed_ns.load(std::memory_order_relaxed);
+            t.vruntime = m.vruntime.load(std::memory_order_relaxed);
+            t.admitted = b.admitted.load(std::memory_order_relaxed);
+            t.rejected = b.rejected.load(std::memory_order_relaxed);
+            m.waits.read(t.waits);
+            t.wait_max_ns = m.waits.max();
+        }
+
+        auto backlogged = [](const SchedulerSnapshot::Tenant& t) {
+            return std::ranges::any_of(t.depth, [](uint64_t d) { return d > 0; });
+        };
+        bool any_backlogged = std::ranges::any_of(snap.tenants, backlogged);
+        __int128 weighted = 0;
+        uint64_t total_weight = 0;
+        for (const auto& t : snap.tenants) {
+            if (any_backlogged ? !backlogged(t) : t.vruntime == 0) continue;
+            weighted += static_cast<__int128>(t.vruntime) * t.weight;
+            total_weight += t.weight;
+        }
+        auto mean = total_weight ? static_cast<int64_t>(weighted / total_weight) : 0;
+        for (auto& t : snap.tenants) t.lag = mean - static_cast<int64_t>(t.vruntime);
+        return snap;
+    }
+
+    void shutdown() {
+        running_ = false;
+        for (auto& shard : shards_) {
+            // Lock/unlock orders the store before any waiter's predicate check
+            { std::lock_guard lk(shard->mtx); }
+            shard->cv.notify_all();
+        }
+        // Join (jthread dtor) so callers can read per-core state race-free
+        workers_.clear();
+    }
+
+    void print_stats() {
+        std::print("\n\n================ SCHEDULER REPORT ================\n");
+        std::print("Dispatch Mode:    {}, {}\n", mode_ == DispatchMode::SHARDED ? "SHARDED" : "GLOBAL",
+            execution_ == ExecutionModel::VIRTUAL ? "virtual time" : "threaded");
+        std::print("Tenant Picker:    {}, {} vruntime\n",
+            picker_ == TenantPicker::EEVDF ? "EEVDF" : "MIN_VRUNTIME",
+            accounting_ == VruntimeAccounting::MEASURED ? "measured" : "estimated");
+        std::print("Tasks Completed:  {}\n", completed_tasks_.load());
+        std::print("Tasks Dropped:    {}\n", dropped_tasks_.load());
+        std::print("Deadline Misses:  {}\n", deadline_misses_.load());
+        std::print("PI Boost Events:  {}\n", pi_events_.load());
+        std::print("PI Chain Boosts:  {} of {} inherited\n", resource_mgr_.chain_boosts(), resource_mgr_.boosts());
+        std::print("Resource Parks:   {}\n", parked_tasks_.load());
+        std::print("Task Pool:        {} slots, {} in use, {} submissions refused\n",
+            pool_.capacity(), pool_.in_use(), pool_exhausted_.load());
+        auto ps = placement_stats();
+        std::print("NUMA Placement:   {}, {} nodes{}, {} workers pinned, "
+            "{:.1f}% cross-node dispatches, {} of {} steals cross-node\n",
+            numa_aware_ ? "node-local" : "off", ps.nodes, topology_.from_sysfs ? "" : " (modelled)",
+            ps.pinned_workers, ps.dispatched ? 100.0 * ps.remote_dispatches / ps.dispatched : 0.0,
+            ps.remote_steals, ps.steals);
+        std::print("Admission Rate:   {:.0f}/s ({} CoDel throttles), E2E Latency EWMA={:.2f}ms\n",
+            admission_.current_rate(), admission_.throttle_events(), admission_.latency_estimate_ns() / 1e6);
+        
+        CoreStats rest;
+        for(size_t i=0; i<num_cores_; ++i) {
+            const auto& cs = worker_stats_[i];
+            if (i >= MAX_CORE_LINES) {
+                rest.tasks_run += cs.tasks_run;
+                rest.dispatched += cs.dispatched;
+                rest.steals += cs.steals;
+                rest.stolen_tasks += cs.stolen_tasks;
+                rest.idle_ns += cs.idle_ns;
+                continue;
+            }
+            std::print("Core {:02}: Tasks Run={}, Dispatched={}, Steals={} ({} tasks), Idle={}us\n", 
+                i, cs.tasks_run, cs.dispatched, cs.steals, cs.stolen_tasks, cs.idle_ns/1000);
+        }
+        if (num_cores_ > MAX_CORE_LINES) {
+            std::print("Cores {}-{}: Tasks Run={}, Dispatched={}, Steals={} ({} tasks), Idle={}us\n",
+                MAX_CORE_LINES, num_cores_ - 1, rest.tasks_run, rest.dispatched, rest.steals,
+                rest.stolen_tasks, rest.idle_ns/1000);
+        }
+
+        // Tenant lanes exist per shard; report the sum across shards.
+        std::map<uint64_t, TenantState> totals;
+        for (auto& shard : shards_) {
+            std::lock_guard lk(shard->mtx);
+            for (const auto& [id, state] : shard->rq.tenants()) {
+                auto& agg = totals.try_emplace(id, TenantState{id, state.weight, 0, {}}).first->second;
+                agg.vruntime += state.vruntime;
+                agg.executed_ns += state.executed_ns;
+            }
+        }
+
+        std::print("\n--- Tenant Fairness (Virtual Runtime) ---\n");
+        for(const auto& [id, state] : totals) {
+            std::print("Tenant {:2}: Weight={:3}, Executed={:.2f}ms, VRuntime={}\n",
+                id, state.weight, state.executed_ns/1e6, state.vruntime);
+        }
+
+        std::print("\n--- Tenant Wait Time ---\n");
+        for (const auto& t : snapshot().tenants) {
+            std::print("Tenant {:2}: p50={:.3f}ms, p99={:.3f}ms, p999={:.3f}ms, max={:.3f}ms, lag={}\n",
+                t.id, t.wait_quantile(0.50) / 1e6, t.wait_quantile(0.99) / 1e6, t.wait_quantile(0.999) / 1e6,
+                t.wait_max_ns / 1e6, t.lag);
+        }
+
+        std::print("\n--- Tenant Admission ---\n");
+        for(const auto& [id, state] : totals) {
+            if (const auto* b = tenant_admission_.find(id)) {
+                std::print("Tenant {:2}: Admitted={}, Rejected={}, Borrowed={}\n",
+                    id, b->admitted.load(), b->rejected.load(), b->borrowed.load());
+            }
+        }
+        std::print("==================================================\n");
+    }
+
+private:
+    static ExecutionModel enter_execution_model(ExecutionModel m) {
+        if (m == ExecutionModel::VIRTUAL) sys::VirtualClock::enable(0);
+        return m;
+    }
+
+    // Resources are taken in ascending id order (ResourceManager's lock
+    // order): a nested request naming them the other way round is swapped,
+    // and naming one resource twice needs it once.
+    Task make_task(SubmitRequest r, uint64_t now) {
+        if (r.nested_resource_need != 0 && r.resource_need > r.nested_resource_need) {
+            std::swap(r.resource_need, r.nested_resource_need);
+        }
+        if (r.nested_resource_need == r.resource_need) r.nested_resource_need = 0;
+        return Task{
+            .id = rng_.next(),
+            .tenant_id = r.tenant_id,
+            .base_priority = r.prio,
+            .current_priority = r.prio,
+            .enqueue_time_ns = now,
+            .deadline_ns = now + r.deadline_offset_ns,
+            .estimated_cost_ns = r.cost_ns,
+            .required_resource_id = r.resource_need,
+            .nested_resource_id = r.nested_resource_need
+        };
+    }
+
+    CoreShard& next_shard(uint32_t node) {
+        size_t n = next_shard_.fetch_add(1, std::memory_order_relaxed);
+        if (numa_aware_ && mode_ == DispatchMode::SHARDED) {
+            const auto& local = node_shards_[node];
+            return *shards_[local[n % local.size()]];
+        }
+        return *shards_[n % shards_.size()];
+    }
+
+    // Maps cores onto topology nodes and, if `pin`, onto CPUs. Core i takes
+    // the CPU at position i*cpus/cores in node order, so a machine with fewer
+    // workers than CPUs still spreads them over every node.
+    void place_cores(bool pin) {
+        std::vector<std::pair<uint32_t, int>> cpus; // (topology node, cpu) in node order
+        for (size_t n = 0; n < topology_.nodes(); ++n) {
+            for (int cpu : topology_.node_cpus[n]) cpus.emplace_back(static_cast<uint32_t>(n), cpu);
+        }
+        std::map<uint32_t, uint32_t> dense; // Topology node -> node with cores
+        for (size_t i = 0; i < num_cores_; ++i) {
+            auto [node, cpu] = cpus[i * cpus.size() / num_cores_];
+            auto it = dense.try_emplace(node, static_cast<uint32_t>(dense.size())).first;
+            core_node_.push_back(it->second);
+            core_cpu_.push_back(pin ? cpu : -1);
+        }
+
+        size_t nodes = std::max<size_t>(1, dense.size());
+        node_shards_.assign(nodes, {});
+        node_weight_.assign(nodes, 0);
+        wake_order_.assign(nodes, {});
+        if (mode_ == DispatchMode::SHARDED) {
+            for (size_t i = 0; i < num_cores_; ++i) node_shards_[core_node_[i]].push_back(i);
+        } else {
+            node_shards_[0].push_back(0);
+        }
+        for (size_t n = 0; n < nodes; ++n) {
+            for (size_t k = 0; k < nodes; ++k) {
+                // Without NUMA awareness every node wakes in plain shard order
+                const auto& src = node_shards_[numa_aware_ ? (n + k) % nodes : k];
+                wake_order_[n].insert(wake_order_[n].end(), src.begin(), src.end());
+            }
+        }
+    }
+
+    // Homes a tenant on the node carrying the least weight; a re-registered
+    // tenant keeps its node (and its live metrics) and only moves its weight.
+    std::pair<uint32_t, TenantMetrics*> home_tenant(uint64_t id, uint64_t weight) {
+        std::lock_guard lk(placement_mtx_);
+        auto it = tenant_home_.find(id);
+        if (it != tenant_home_.end()) {
+            TenantHome& home = it->second;
+            node_weight_[home.node] += weight - home.weight;
+            home.weight = weight;
+            home.live->weight.store(weight, std::memory_order_relaxed);
+            return {home.node, home.live.get()};
+        }
+        auto node = static_cast<uint32_t>(std::ranges::min_element(node_weight_) - node_weight_.begin());
+        node_weight_[node] += weight;
+        auto live = std::make_unique<TenantMetrics>();
+        live->weight.store(weight, std::memory_order_relaxed);
+        TenantMetrics* raw = live.get();
+        tenant_home_.emplace(id, TenantHome{node, weight, std::move(live)});
+        return {node, raw};
+    }
+
+    void note_dispatch(size_t core_id, TaskRef ref) {
+        auto& cs = worker_stats_[core_id];
+        cs.dispatched++;
+        const auto* budget = tenant_admission_.find(pool_[ref].tenant_id);
+        if (budget && budget->home_node.load(std::memory_order_relaxed) != core_node_[core_id]) {
+            cs.remote_dispatches++;
+        }
+    }
+
+    // Wake at most `runnable` parked workers: the target shard's own first,
+    // then (SHARDED) idle cores elsewhere, which steal the surplus. Called
+    // after the tasks are visible under target.mtx, so a worker not yet
+    // counted in sleepers will see them in its wait predicate.
+    void wake_workers(CoreShard& target, size_t runnable) {
+        if (runnable == 0) return;
+        if (execution_ == ExecutionModel::VIRTUAL) {
+            virtual_wake(target, runnable);
+            return;
+        }
+
+        size_t local = std::min<size_t>(runnable, target.sleepers.load(std::memory_order_relaxed));
+        if (local > 0 && local == target.sleepers.load(std::memory_order_relaxed)) {
+            target.cv.notify_all();
+        } else {
+            for (size_t i = 0; i < local; ++i) target.cv.notify_one();
+        }
+
+        size_t woken = local;
+        if (mode_ != DispatchMode::SHARDED) return;
+        for (size_t i : wake_order_[core_node_[target.index]]) {
+            if (woken >= runnable) break;
+            auto& shard = shards_[i];
+            if (shard.get() == &target) continue;
+            if (shard->sleepers.load(std::memory_order_relaxed) > 0) {
+                shard->cv.notify_one();
+                ++woken;
+            }
+        }
+    }
+
+    CoreShard& home_shard(size_t core_id) {
+        return *shards_[mode_ == DispatchMode::SHARDED ? core_id : 0];
+    }
+
+    void worker_loop(size_t core_id, std::stop_token st) {
+        CoreShard& home = home_shard(core_id);
+        if (core_cpu_[core_id] >= 0 && sys::pin_current_thread(core_cpu_[core_id])) {
+            pinned_workers_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        sys::Micro steal_poll = STEAL_POLL_MIN;
+        while (!st.stop_requested() && running_) {
+            TaskRef task_to_run = NO_TASK;
+
+            {
+                std::unique_lock lk(home.mtx);
+                auto ready = [&] { return !running_ || !home.rq.empty(); };
+                uint64_t wait_start = sys::now_ns();
+
+                home.sleepers.fetch_add(1, std::memory_order_relaxed);
+                if (mode_ == DispatchMode::SHARDED) {
+                    // wake_workers() already notifies sleeping shards when a push leaves
+                    // surplus; the timeout only covers a notify that raced our sleepers
+                    // increment, so it backs off while the core keeps finding nothing.
+                    home.cv.wait_for(lk, steal_poll, ready);
+                } else {
+                    // Wait for work or shutdown
+                    home.cv.wait(lk, ready);
+                }
+                home.sleepers.fetch_sub(1, std::memory_order_relaxed);
+                worker_stats_[core_id].idle_ns += sys::now_ns() - wait_start;
+
+                if (!running_) break;
+
+                task_to_run = home.rq.pop_next();
+                if (task_to_run != NO_TASK) home.depth.fetch_sub(1, std::memory_order_relaxed);
+            } // unlock
+
+            if (task_to_run == NO_TASK && mode_ == DispatchMode::SHARDED) {
+                task_to_run = steal_work(core_id);
+            }
+
+            if (task_to_run != NO_TASK) {
+                steal_poll = STEAL_POLL_MIN;
+                note_dispatch(core_id, task_to_run);
+                execute_task(core_id, task_to_run);
+            } else {
+                steal_poll = std::min(steal_poll * 2, STEAL_POLL_MAX);
+            }
+        }
+    }
+
+    // Pull a batch from the most loaded shard into our own and dispatch from it.
+    // Depth counters are read relaxed; a stale pick just yields an empty steal.
+    // NUMA-aware cores look on their own node first.
+    TaskRef steal_work(size_t core_id) {
+        auto deepest = [&](bool local_only) {
+            size_t victim = core_id;
+            size_t best_depth = 0;
+            for (size_t k = 1; k < shards_.size(); ++k) {
+                size_t i = (core_id + k) % shards_.size();
+                if (local_only && core_node_[i] != core_node_[core_id]) continue;
+                size_t d = shards_[i]->depth.load(std::memory_order_relaxed);
+                if (d > best_depth) {
+                    best_depth = d;
+                    victim = i;
+                }
+            }
+            return victim;
+        };
+        size_t victim = deepest(numa_aware_);
+        if (victim == core_id && numa_aware_) victim = deepest(false);
+        if (victim == core_id) return NO_TASK;
+
+        CoreShard& src = *shards_[victim];
+        CoreShard& dst = *shards_[core_id];
+        std::scoped_lock lk(src.mtx, dst.mtx);
+
+        // Take half of the victim's backlog (at least one task), capped per steal
+        size_t want = std::min(STEAL_BATCH, (src.rq.size() + 1) / 2);
+        size_t moved = src.rq.steal_into(dst.rq, want);
+        if (moved == 0) return NO_TASK;
+
+        src.depth.fetch_sub(moved, std::memory_order_relaxed);
+        dst.depth.fetch_add(moved, std::memory_order_relaxed);
+        worker_stats_[core_id].steals++;
+        worker_stats_[core_id].stolen_tasks += moved;
+        if (core_node_[victim] != core_node_[core_id]) worker_stats_[core_id].remote_steals++;
+
+        TaskRef t = dst.rq.pop_next();
+        if (t != NO_TASK) dst.depth.fetch_sub(1, std::memory_order_relaxed);
+        return t;
+    }
+
+    void execute_task(size_t core_id, TaskRef ref) {
+        if (!begin_task(core_id, ref)) return;
 
         // 3. Execution (Simulated Busy Wait)
         // If boosted, we might run faster? (Not in this physics model, but effectively yes in real CPU)
-        
-        uint64_t actual_cost = t.estimated_cost_ns;
-        // Add random variance +/- 10%
-        // We can't use the member rng_ here without locking, so use local logic or standard
-        // For simplicity:
-        busy_wait_ns(actual_cost);
+        busy_wait_ns(execution_cost(core_id, pool_[ref]));
+
+        finish_task(core_id, ref);
+    }
+
+    // Steps before execution. Returns false if the task parked on a resource.
+    bool begin_task(size_t core_id, TaskRef ref) {
+        Task& t = pool_[ref];
+        t.start_time_ns = sys::now_ns();
+        worker_stats_[core_id].tasks_run++;
+
+        // 1. Resource Acquisition Check
+        if (!resource_mgr_.acquire_or_park(ref, [this](TaskRef owner, Priority p) { boost_queued(owner, p); })) {
+            // TASK BLOCKED. Parked on the resource's wait queue; the owner's
+            // release() hands the resource over and re-enqueues it.
+            parked_tasks_++;
+            if (accounting_ == VruntimeAccounting::MEASURED) {
+                // It did not run: take back the estimate charged at dispatch
+                CoreShard& home = home_shard(core_id);
+                std::lock_guard lk(home.mtx);
+                home.rq.complete(t.tenant_id, t.estimated_cost_ns, 0, accounting_);
+            }
+            return false;
+        }
+
+        // Queue delay, not end-to-end latency, drives admission (CoDel)
+        admission_.feedback_sojourn(t.start_time_ns - t.enqueue_time_ns, t.start_time_ns);
+        if (const auto* b = tenant_admission_.find(t.tenant_id); b && b->live) {
+            b->live->waits.record(t.start_time_ns - t.enqueue_time_ns);
+        }
 
-        // 4. Cleanup
-        if (t.required_resource_id != 0) {
-            resource_mgr_.release(t.required_resource_id);
+        // 2. Check for Priority Inheritance Logic
+        // While running, this task might be holding a lock that a CRITICAL task wants.
+        // We simulate "checking" periodically or before running.
+        auto boost_prio = resource_mgr_.check_priority_inheritance(ref);
+        if (boost_prio.has_value() && boost_prio.value() < t.current_priority) {
+            telemetry::info("PIP: Task {} boosted from {} to {}", 
+                t.id, to_string(t.current_priority), to_string(boost_prio.value()));
+            t.current_priority = boost_prio.value();
+            pi_events_++;
         }
+        return true;
+    }
+
+    // Add random variance +/- 10% (per-core generator, no locking)
+    uint64_t execution_cost(size_t core_id, const Task& t) {
+        return t.estimated_cost_ns / 100 * core_rng_[core_id].range(90, 110);
+    }
+
+    // Steps after execution: release, metrics, accounting. Frees the slot.
+    void finish_task(size_t core_id, TaskRef ref) {
+        Task& t = pool_[ref];
+
+        // 4. Cleanup: hand each held resource to its next waiter, if any
+        resource_mgr_.release_all(ref, [&](TaskRef next_owner) {
+            make_runnable(core_id, next_owner);
+        });
 
         t.finish_time_ns = sys::now_ns();
         
         // 5. Metrics & Feedback
         uint64_t latency = t.finish_time_ns - t.enqueue_time_ns;
-        admission_.feedback_latency(latency); // Feed into CoDel loop
+        admission_.feedback_latency(latency); // EWMA estimate
 
         completed_tasks_++;
         if (t.missed_deadline()) {
@@ -633,27 +2657,539 @@ private:
         }
 
         {
-            std::lock_guard lk(sched_mtx_);
-            tenants_[t.tenant_id].executed_ns += actual_cost;
+            CoreShard& home = home_shard(core_id);
+            std::lock_guard lk(home.mtx);
+            home.rq.complete(t.tenant_id, t.estimated_cost_ns, t.finish_time_ns - t.start_time_ns, accounting_);
+        }
+        if (on_complete_) on_complete_(core_id, t);
+        pool_.release(ref);
+    }
+
+    // A waiter that was just handed its resource: queue it at the head of its
+    // class so the resource is not held idle, on a shard picked the way
+    // submit() picks one (the tenant's home node when NUMA-aware), so a
+    // handoff from another node does not migrate it.
+    void make_runnable(size_t core_id, TaskRef ref) {
+        const auto* budget = tenant_admission_.find(pool_[ref].tenant_id);
+        CoreShard& target = budget ? next_shard(budget->home_node.load(std::memory_order_relaxed))
+                                   : home_shard(core_id);
+        {
+            std::lock_guard lk(target.mtx);
+            target.rq.push_front(ref);
+            target.depth.fetch_add(1, std::memory_order_relaxed);
+        }
+        wake_workers(target, 1);
+    }
+
+    // A resource owner boosted while handed its resource but not yet
+    // dispatched: move it up in whichever run queue holds it. Called under
+    // ResourceManager's lock, which is always taken before shard locks. A
+    // task that is no longer queued picks the boost up in begin_task().
+    void boost_queued(TaskRef ref, Priority prio) {
+        while (true) {
+            uint32_t q = pool_.queue_of(ref);
+            if (q == TaskPool::NOT_QUEUED) return;
+            CoreShard& shard = *shards_[q];
+            std::lock_guard lk(shard.mtx);
+            if (pool_.queue_of(ref) != q) continue; // Stolen meanwhile
+            if (shard.rq.boost(ref, prio)) {
+                telemetry::info("PIP: queued Task {} boosted to {}", pool_[ref].id, to_string(prio));
+                pi_events_++;
+            }
+            return;
+        }
+    }
+
+    // ---- VIRTUAL execution ----
+    // Cores are idle-stack entries or own one running task with a completion
+    // event. The code paths are the threaded ones (pop_next, steal_work,
+    // begin_task/finish_task) minus the busy wait. Wakeups are queued and
+    // dispatched once the caller is back in the event loop: a resource handoff
+    // wakes from inside ResourceManager's lock, which a dispatch re-enters.
+
+    void run_next_event() {
+        VirtualEvent ev = events_.top();
+        events_.pop();
+        sys::VirtualClock::advance_to(ev.at);
+
+        TaskRef ref = std::exchange(running_tasks_[ev.core], NO_TASK);
+        finish_task(ev.core, ref);
+        set_idle(ev.core);
+        virtual_dispatch(ev.core);
+        flush_wakes();
+    }
+
+    void virtual_wake(CoreShard& target, size_t runnable) {
+        pending_wakes_.emplace_back(target.index, runnable);
+    }
+
+    // Mirrors the threaded wakeup: the target shard's idle core first, then
+    // any idle core (the target's node first), which takes from its home
+    // queue or steals.
+    void flush_wakes() {
+        for (size_t w = 0; w < pending_wakes_.size(); ++w) {
+            auto [shard, runnable] = pending_wakes_[w];
+            size_t woken = 0;
+            if (mode_ == DispatchMode::SHARDED && idle_slot_[shard] != NOT_IDLE) {
+                ++woken;
+                virtual_dispatch(shard);
+            }
+            size_t first = idle_group(shard);
+            for (size_t k = 0; k < idle_cores_.size() && woken < runnable; ++k) {
+                auto& idle = idle_cores_[(first + k) % idle_cores_.size()];
+                bool drained = false;
+                while (woken < runnable && !idle.empty()) {
+                    ++woken;
+                    if (!virtual_dispatch(idle.back())) { drained = true; break; } // Nothing left to take
+                }
+                if (drained) break;
+            }
+        }
+        pending_wakes_.clear();
+    }
+
+    size_t idle_group(size_t core_id) const { return numa_aware_ ? core_node_[core_id] : 0; }
+
+    // Start the next runnable task on an idle core; false if none was found.
+    bool virtual_dispatch(size_t core_id) {
+        CoreShard& home = home_shard(core_id);
+        while (true) {
+            TaskRef ref;
+            {
+                std::lock_guard lk(home.mtx);
+                ref = home.rq.pop_next();
+                if (ref != NO_TASK) home.depth.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (ref == NO_TASK && mode_ == DispatchMode::SHARDED) ref = steal_work(core_id);
+            if (ref == NO_TASK) return false;
+
+            note_dispatch(core_id, ref);
+            if (!begin_task(core_id, ref)) continue; // Parked; the core is still free
+
+            set_busy(core_id);
+            uint64_t finish = sys::now_ns() + execution_cost(core_id, pool_[ref]);
+            running_tasks_[core_id] = ref;
+            events_.push({finish, core_id});
+            return true;
         }
     }
 
+    void set_idle(size_t core_id) {
+        auto& idle = idle_cores_[idle_group(core_id)];
+        idle_slot_[core_id] = idle.size();
+        idle.push_back(core_id);
+        idle_since_[core_id] = sys::now_ns();
+    }
+
+    void set_busy(size_t core_id) {
+        auto& idle = idle_cores_[idle_group(core_id)];
+        size_t slot = idle_slot_[core_id];
+        size_t last = idle.back();
+        idle[slot] = last;
+        idle_slot_[last] = slot;
+        idle.pop_back();
+        idle_slot_[core_id] = NOT_IDLE;
+        worker_stats_[core_id].idle_ns += sys::now_ns() - idle_since_[core_id];
+    }
+
     // Precise busy wait
     static void busy_wait_ns(uint64_t ns) {
         auto start = std::chrono::steady_clock::now();
         while(true) {
             auto now = std::chrono::steady_clock::now();
-            if (std::chrono::duration_cast<Nano>(now - start).count() >= ns) break;
+            if (std::chrono::duration_cast<sys::Nano>(now - start).count() >= ns) break;
             std::atomic_signal_fence(std::memory_order_acquire); // Prevent compiler optimization
         }
     }
 };
 
+// ----------------------------- Benchmark Harness -----------------------------
+//
+// Repeatable load for comparing scheduler changes. A trace is a list of
+// arrivals (offset, tenant, priority, cost, deadline, resources) plus the
+// tenant weights, synthesized from a seeded sys::Random or read from disk.
+// It is replayed open-loop (arrivals follow the trace clock whatever the
+// scheduler does) against either the threaded scheduler or its virtual-time
+// execution model, which is deterministic and spins no cores.
+
+namespace bench {
+
+struct TraceTenant {
+    uint64_t id;
+    uint64_t weight;
+};
+
+struct TraceRecord {
+    uint64_t arrival_ns;         // Offset from trace start
+    uint64_t tenant_id;
+    uint64_t cost_ns;
+    uint64_t deadline_offset_ns;
+    uint32_t resource_need;
+    uint32_t nested_resource_need;
+    Priority prio;
+    std::array<uint8_t, 7> pad{};
+};
+static_assert(sizeof(TraceRecord) == 48 && std::is_trivially_copyable_v<TraceRecord>);
+
+struct Trace {
+    std::vector<TraceTenant> tenants;
+    std::vector<TraceRecord> records; // Sorted by arrival_ns
+
+    uint64_t span_ns() const { return records.empty() ? 0 : records.back().arrival_ns; }
+};
+
+// On-disk layout (host byte order; every target we run is little-endian):
+//   TraceHeader, tenant_count x TraceTenant, record_count x TraceRecord
+struct TraceHeader {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t tenant_count;
+    uint64_t record_count;
+};
+
+inline constexpr std::array<char, 8> TRACE_MAGIC{'H', 'W', 'F', 'Q', 'T', 'R', 'C', '1'};
+inline constexpr uint32_t TRACE_VERSION = 1;
+
+std::expected<void, std::string> write_trace(const char* path, const Trace& trace) {
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> f(std::fopen(path, "wb"), &std::fclose);
+    if (!f) return std::unexpected(std::format("cannot open {} for writing", path));
+
+    TraceHeader h{TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord), trace.tenants.size(), trace.records.size()};
+    bool ok = std::fwrite(&h, sizeof(h), 1, f.get()) == 1 &&
+              std::fwrite(trace.tenants.data(), sizeof(TraceTenant), trace.tenants.size(), f.get()) == trace.tenants.size() &&
+              std::fwrite(trace.records.data(), sizeof(TraceRecord), trace.records.size(), f.get()) == trace.records.size();
+    if (!ok) return std::unexpected(std::format("short write to {}", path));
+    return {};
+}
+
+std::expected<Trace, std::string> read_trace(const char* path) {
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> f(std::fopen(path, "rb"), &std::fclose);
+    if (!f) return std::unexpected(std::format("cannot open {}", path));
+
+    TraceHeader h{};
+    if (std::fread(&h, sizeof(h), 1, f.get()) != 1 || h.magic != TRACE_MAGIC) {
+        return std::unexpected(std::format("{} is not a scheduler trace", path));
+    }
+    if (h.version != TRACE_VERSION || h.record_size != sizeof(TraceRecord)) {
+        return std::unexpected(std::format("{}: unsupported trace version {}", path, h.version));
+    }
+
+    // Size the vectors only from counts the file can actually back; a corrupt
+    // header must not turn into a multi-gigabyte resize.
+    std::error_code ec;
+    uint64_t file_size = std::filesystem::file_size(path, ec);
+    if (ec) return std::unexpected(std::format("cannot stat {}: {}", path, ec.message()));
+    uint64_t payload = file_size - std::min<uint64_t>(file_size, sizeof(h));
+    uint64_t record_bytes = h.tenant_count <= payload / sizeof(TraceTenant)
+                                ? payload - h.tenant_count * sizeof(TraceTenant) : 1;
+    if (record_bytes % sizeof(TraceRecord) != 0 || h.record_count != record_bytes / sizeof(TraceRecord)) {
+        return std::unexpected(std::format("{}: header counts {} tenants, {} records do not match {} payload bytes",
+                                           path, h.tenant_count, h.record_count, payload));
+    }
+
+    Trace trace;
+    trace.tenants.resize(h.tenant_count);
+    trace.records.resize(h.record_count);
+    bool ok = std::fread(trace.tenants.data(), sizeof(TraceTenant), h.tenant_count, f.get()) == h.tenant_count &&
+              std::fread(trace.records.data(), sizeof(TraceRecord), h.record_count, f.get()) == h.record_count;
+    if (!ok) return std::unexpected(std::format("{}: truncated trace", path));
+    if (std::ranges::any_of(trace.records, [](const TraceRecord& r) { return r.prio > Priority::LOW; })) {
+        return std::unexpected(std::format("{}: record with invalid priority", path));
+    }
+    if (!std::ranges::is_sorted(trace.records, {}, &TraceRecord::arrival_ns)) {
+        return std::unexpected(std::format("{}: arrivals out of order", path));
+    }
+    return trace;
+}
+
+struct SynthConfig {
+    uint64_t seed = 12345;
+    double rate = 2000;              // Mean arrivals/sec (Poisson)
+    uint64_t duration_ns = 5'000'000'000;
+};
+
+// Same tenant, priority, resource and cost mix as run_simulation()'s generator.
+Trace synthesize(const SynthConfig& cfg) {
+    Trace trace;
+    trace.tenants = {{1, 200}, {2, 100}, {3, 50}};
+    sys::Random rng(cfg.seed);
+
+    const double mean_gap_ns = 1e9 / cfg.rate;
+    double t = 0;
+    while (true) {
+        t += -std::log(1.0 - rng.uniform()) * mean_gap_ns;
+        if (t >= static_cast<double>(cfg.duration_ns)) break;
+
+        uint64_t r = rng.next() % 100;
+        uint64_t tenant = (r < 50) ? 1 : (r < 80 ? 2 : 3);
+
+        uint64_t p_rand = rng.next() % 100;
+        Priority p = Priority::NORMAL;
+        if (p_rand < 5) p = Priority::CRITICAL;
+        else if (p_rand < 20) p = Priority::HIGH;
+        else if (p_rand > 80) p = Priority::LOW;
+
+        uint32_t res_id = 0;
+        uint32_t nested_id = 0;
+        uint64_t res_roll = rng.next() % 100;
+        if (res_roll < 5) {
+            res_id = 1;
+            if (rng.next() % 3 == 0) nested_id = 2;
+        } else if (res_roll < 8) {
+            res_id = 2;
+        }
+
+        uint64_t cost = rng.range(500'000, 3'000'000);
+        uint64_t deadline = cost * rng.range(2, 10);
+        trace.records.push_back({static_cast<uint64_t>(t), tenant, cost, deadline, res_id, nested_id, p});
+    }
+    return trace;
+}
+
+// Rescale arrival offsets so the trace plays at `rate` arrivals/sec on average.
+void retime(Trace& trace, double rate) {
+    if (trace.records.size() < 2 || rate <= 0) return;
+    double target_span = static_cast<double>(trace.records.size()) / rate * 1e9;
+    double scale = target_span / static_cast<double>(trace.span_ns());
+    for (auto& r : trace.records) {
+        r.arrival_ns = static_cast<uint64_t>(static_cast<double>(r.arrival_ns) * scale);
+    }
+}
+
+struct RunResult {
+    const char* mode;
+    uint64_t submitted{0};
+    uint64_t rejected{0};
+    uint64_t completed{0};
+    uint64_t deadline_misses{0};
+    uint64_t elapsed_ns{0};      // Trace clock: wall time open-loop, simulated time virtual
+    uint64_t host_ns{0};         // Wall time spent producing the result
+    std::vector<uint64_t> waits{}; // start - enqueue per completed task
+    std::map<uint64_t, uint64_t> executed_ns{}; // Per tenant, tasks finished before the last arrival
+    HierarchicalScheduler::PlacementStats placement{};
+    size_t snapshots{0};
+    uint64_t snapshot_host_ns{0}; // Host time spent taking and writing them
+};
+
+inline uint64_t percentile(std::vector<uint64_t>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    size_t i = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1));
+    return sorted[i];
+}
+
+void print_report(const Trace& trace, RunResult& r) {
+    std::ranges::sort(r.waits);
+    double secs = static_cast<double>(r.elapsed_ns) / 1e9;
+
+    std::print("\n================ BENCHMARK ({}) ================\n", r.mode);
+    std::print("Arrivals:         {} submitted, {} rejected\n", r.submitted, r.rejected);
+    std::print("Completed:        {} in {:.3f}s ({:.0f} dispatches/s), host {:.3f}s\n",
+        r.completed, secs, secs > 0 ? static_cast<double>(r.completed) / secs : 0.0, r.host_ns / 1e9);
+    std::print("Deadline Misses:  {}\n", r.deadline_misses);
+    std::print("Wait p50/p99/p999: {:.3f} / {:.3f} / {:.3f} ms\n",
+        percentile(r.waits, 0.50) / 1e6, percentile(r.waits, 0.99) / 1e6, percentile(r.waits, 0.999) / 1e6);
+
+    // Share error: observed fraction of executed time vs weight fraction,
+    // over the arrival window only (the drain completes everything anyway).
+    // Meaningful when every tenant stays backlogged (offered load > capacity).
+    uint64_t total_weight = 0;
+    uint64_t total_exec = 0;
+    for (const auto& t : trace.tenants) total_weight += t.weight;
+    for (const auto& [id, ns] : r.executed_ns) total_exec += ns;
+    double max_err = 0;
+    for (const auto& t : trace.tenants) {
+        double ideal = static_cast<double>(t.weight) / static_cast<double>(total_weight);
+        double got = total_exec ? static_cast<double>(r.executed_ns[t.id]) / static_cast<double>(total_exec) : 0.0;
+        max_err = std::max(max_err, std::abs(got - ideal));
+        std::print("Tenant {:2}: Weight={:3}, Share={:6.2f}% (ideal {:6.2f}%, error {:+.2f}pp)\n",
+            t.id, t.weight, got * 100, ideal * 100, (got - ideal) * 100);
+    }
+    std::print("Max Share Error:  {:.2f}pp\n", max_err * 100);
+
+    // Cross-node traffic: a dispatch outside the tenant's home node touches
+    // its lane and task slots remotely; a cross-node steal migrates a batch.
+    const auto& p = r.placement;
+    std::print("NUMA ({} nodes):   {:.1f}% cross-node dispatches ({} of {}), {} of {} steals cross-node\n",
+        p.nodes, p.dispatched ? 100.0 * p.remote_dispatches / p.dispatched : 0.0,
+        p.remote_dispatches, p.dispatched, p.remote_steals, p.steals);
+    if (r.snapshots) {
+        std::print("Snapshots:        {} taken, {:.1f}us each\n",
+            r.snapshots, r.snapshot_host_ns / 1e3 / static_cast<double>(r.snapshots));
+    }
+    std::print("==================================================\n");
+}
+
+struct BenchOptions {
+    DispatchMode mode = DispatchMode::GLOBAL;
+    ExecutionModel execution = ExecutionModel::THREADED;
+    VruntimeAccounting accounting = VruntimeAccounting::ESTIMATED;
+    TenantPicker picker = TenantPicker::MIN_VRUNTIME;
+    size_t cores = 4;
+    uint64_t base_rate = 2000;
+    uint32_t task_capacity = 1 << 16;
+    bool numa_aware = false;
+    size_t numa_nodes = 0;
+    const char* snapshot_path = nullptr; // Live snapshots: JSON lines, or binary for *.bin
+    uint64_t snapshot_interval_ns = 100'000'000;
+};
+
+// Appends scheduler snapshots to a file, one JSON line each or back-to-back
+// binary records.
+class SnapshotWriter {
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> f_{nullptr, &std::fclose};
+    bool binary_{false};
+
+public:
+    static std::expected<SnapshotWriter, std::string> open(const char* path) {
+        SnapshotWriter w;
+        w.f_.reset(std::fopen(path, "wb"));
+        if (!w.f_) return std::unexpected(std::format("cannot open {} for writing", path));
+        w.binary_ = std::string_view(path).ends_with(".bin");
+        return w;
+    }
+
+    void write(const SchedulerSnapshot& snap) {
+        if (binary_) {
+            auto bytes = snap.to_binary();
+            std::fwrite(bytes.data(), 1, bytes.size(), f_.get());
+        } else {
+            std::string line = snap.to_json_line();
+            line += '\n';
+            std::fwrite(line.data(), 1, line.size(), f_.get());
+        }
+    }
+};
+
+// Submits each record at its trace offset from a single thread, regardless
+// of rejections or backlog, then waits for the admitted work to drain.
+// THREADED: open-loop against wall-clock time. VIRTUAL: the scheduler's
+// discrete-event mode runs every completion due before each arrival, so the
+// run is deterministic and costs only the scheduling work itself.
+RunResult replay(const Trace& trace, const BenchOptions& opt) {
+    const bool virtual_time = opt.execution == ExecutionModel::VIRTUAL;
+    RunResult r{.mode = virtual_time ? "virtual" : "open-loop"};
+    const uint64_t host_start = sys::host_now_ns();
+
+    // Per-core sample buffers, written only by their worker
+    struct CoreSamples {
+        std::vector<uint64_t> waits;
+        std::map<uint64_t, uint64_t> executed_ns;
+        uint64_t misses{0};
+    };
+    std::vector<CoreSamples> samples(opt.cores);
+    std::atomic<uint64_t> completed{0};
+    uint64_t window_end_ns = 0;
+
+    std::optional<SnapshotWriter> writer;
+    if (opt.snapshot_path) {
+        auto opened = SnapshotWriter::open(opt.snapshot_path);
+        if (opened) writer = std::move(*opened);
+        else std::print("Snapshot Error: {}\n", opened.error());
+    }
+
+    HierarchicalScheduler sched({
+        .cores = opt.cores, .base_rate = opt.base_rate, .mode = opt.mode, .execution = opt.execution,
+        .task_capacity = opt.task_capacity, .accounting = opt.accounting, .picker = opt.picker,
+        .numa_aware = opt.numa_aware, .numa_nodes = opt.numa_nodes,
+        .on_complete = [&](size_t core_id, const Task& t) {
+            auto& s = samples[core_id];
+            s.waits.push_back(t.wait_time());
+            if (t.finish_time_ns <= window_end_ns) s.executed_ns[t.tenant_id] += t.finish_time_ns - t.start_time_ns;
+            if (t.missed_deadline()) ++s.misses;
+            completed.fetch_add(1, std::memory_order_release);
+        }});
+    for (const auto& t : trace.tenants) sched.register_tenant(t.id, t.weight);
+    sched.start();
+
+    // Read after construction: a VIRTUAL scheduler switches the clock
+    const uint64_t start_ns = sys::now_ns();
+    window_end_ns = start_ns + trace.span_ns();
+    const sys::TimePoint start{sys::Nano(start_ns)};
+
+    auto take_snapshot = [&] {
+        uint64_t t0 = sys::host_now_ns();
+        writer->write(sched.snapshot());
+        r.snapshot_host_ns += sys::host_now_ns() - t0;
+        ++r.snapshots;
+    };
+    // Threaded runs poll from their own thread while workers dispatch;
+    // virtual runs stop the clock at each interval on the driver thread.
+    std::jthread sampler;
+    if (writer && !virtual_time) {
+        sampler = std::jthread([&](std::stop_token st) {
+            for (auto next = start; !st.stop_requested(); ) {
+                next += sys::Nano(opt.snapshot_interval_ns);
+                std::this_thread::sleep_until(next);
+                if (!st.stop_requested()) take_snapshot();
+            }
+        });
+    }
+    uint64_t next_snapshot_ns = start_ns + opt.snapshot_interval_ns;
+
+    uint64_t admitted = 0;
+    for (const auto& rec : trace.records) {
+        while (writer && virtual_time && next_snapshot_ns <= start_ns + rec.arrival_ns) {
+            sched.advance_to(next_snapshot_ns);
+            take_snapshot();
+            next_snapshot_ns += opt.snapshot_interval_ns;
+        }
+        if (virtual_time) sched.advance_to(start_ns + rec.arrival_ns);
+        else std::this_thread::sleep_until(start + sys::Nano(rec.arrival_ns));
+        auto res = sched.submit(rec.tenant_id, rec.prio, rec.cost_ns, rec.deadline_offset_ns,
+                                rec.resource_need, rec.nested_resource_need);
+        ++r.submitted;
+        if (res) ++admitted;
+        else ++r.rejected;
+    }
+
+    if (virtual_time) {
+        sched.run_until_idle();
+    } else {
+        // Drain (bounded, in case a configuration strands work)
+        const auto drain_limit = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (completed.load(std::memory_order_acquire) < admitted &&
+               std::chrono::steady_clock::now() < drain_limit) {
+            std::this_thread::sleep_for(sys::Micro(500));
+        }
+    }
+    r.elapsed_ns = sys::now_ns() - start_ns;
+    if (sampler.joinable()) {
+        sampler.request_stop();
+        sampler.join();
+    }
+    if (writer) take_snapshot(); // Final state
+    sched.shutdown();
+    r.host_ns = sys::host_now_ns() - host_start;
+    r.placement = sched.placement_stats();
+
+    for (auto& s : samples) {
+        r.waits.insert(r.waits.end(), s.waits.begin(), s.waits.end());
+        for (const auto& [id, ns] : s.executed_ns) r.executed_ns[id] += ns;
+        r.deadline_misses += s.misses;
+    }
+    r.completed = r.waits.size();
+    return r;
+}
+
+} // namespace bench
+
 // ------------------------------ Test Scenario --------------------------------
 
-void run_simulation() {
+struct SimOptions {
+    DispatchMode mode = DispatchMode::GLOBAL;
+    size_t batch = 0; // >0: generator submits through submit_batch() in groups of this size
+    VruntimeAccounting accounting = VruntimeAccounting::ESTIMATED;
+    TenantPicker picker = TenantPicker::MIN_VRUNTIME;
+    bool numa_aware = false;
+    size_t numa_nodes = 0;
+};
+
+void run_simulation(const SimOptions& opt) {
     // 4 Cores, Base Admission 2000 tasks/sec
-    HierarchicalScheduler sched(4, 2000); 
+    HierarchicalScheduler sched({.cores = 4, .base_rate = 2000, .mode = opt.mode,
+                                 .accounting = opt.accounting, .picker = opt.picker,
+                                 .numa_aware = opt.numa_aware, .numa_nodes = opt.numa_nodes});
     
     // Register Tenants with weights
     // Tenant 1: Premium (Weight 200) - e.g., UI or Payment processing
@@ -670,8 +3206,8 @@ void run_simulation() {
     // Generator Thread
     std::jthread generator([&](std::stop_token st) {
         sys::Random rng(12345);
-        
-        while(!st.stop_requested()) {
+
+        auto next_request = [&] {
             // Randomly pick a tenant
             uint64_t r = rng.next() % 100;
             uint64_t tenant = (r < 50) ? 1 : (r < 80 ? 2 : 3);
@@ -684,21 +3220,47 @@ void run_simulation() {
             else if (p_rand > 80) p = Priority::LOW;
 
             // Tasks needing resources (to trigger PIP)
-            // 5% chance to need Resource 1
+            // 5% chance to need Resource 1, 3% Resource 2. A third of the
+            // Resource 1 holders also nest Resource 2, forming PI chains.
             uint32_t res_id = 0;
-            if ((rng.next() % 100) < 5) res_id = 1;
+            uint32_t nested_id = 0;
+            uint64_t res_roll = rng.next() % 100;
+            if (res_roll < 5) {
+                res_id = 1;
+                if (rng.next() % 3 == 0) nested_id = 2;
+            } else if (res_roll < 8) {
+                res_id = 2;
+            }
 
             uint64_t cost = rng.range(500'000, 3'000'000); // 0.5ms to 3ms
             uint64_t deadline = cost * (rng.range(2, 10)); // Deadline relative to cost
+            return SubmitRequest{tenant, p, cost, deadline, res_id, nested_id};
+        };
+
+        std::vector<SubmitRequest> batch;
+        batch.reserve(opt.batch);
+        
+        while(!st.stop_requested()) {
+            if (opt.batch > 0) {
+                // Same offered rate as the single-submit path, delivered in bursts
+                batch.clear();
+                for (size_t i = 0; i < opt.batch; ++i) batch.push_back(next_request());
+                auto results = sched.submit_batch(batch);
+                bool rejected = std::ranges::any_of(results, [](const SubmitResult& r) { return !r; });
+                std::this_thread::sleep_for(sys::Micro(rejected ? 100 : 50) * opt.batch);
+                continue;
+            }
 
-            auto result = sched.submit(tenant, p, cost, deadline, res_id);
+            SubmitRequest req = next_request();
+            auto result = sched.submit(req.tenant_id, req.prio, req.cost_ns, req.deadline_offset_ns,
+                                       req.resource_need, req.nested_resource_need);
             
             if (!result) {
                 // Backoff if rejected
-                std::this_thread::sleep_for(Micro(100)); 
+                std::this_thread::sleep_for(sys::Micro(100)); 
             } else {
                 // High load: sleep very little
-                std::this_thread::sleep_for(Micro(50));
+                std::this_thread::sleep_for(sys::Micro(50));
             }
         }
     });
@@ -714,20 +3276,113 @@ void run_simulation() {
     
     sched.shutdown();
     sched.print_stats();
+}
+
+struct BenchArgs {
+    bool enabled = false;
+    const char* trace_in = nullptr;  // Replay this trace instead of synthesizing
+    const char* trace_out = nullptr; // Save the trace that is about to run
+    double rate = 0;                 // >0: play arrivals at this mean rate
+    bench::SynthConfig synth;
+    bench::BenchOptions opt;
+};
+
+int run_benchmark(BenchArgs args) {
+    bench::Trace trace;
+    if (args.trace_in) {
+        auto loaded = bench::read_trace(args.trace_in);
+        if (!loaded) {
+            std::print("Trace Error: {}\n", loaded.error());
+            return 1;
+        }
+        trace = std::move(*loaded);
+        bench::retime(trace, args.rate);
+    } else {
+        if (args.rate > 0) args.synth.rate = args.rate;
+        trace = bench::synthesize(args.synth);
+    }
+    if (args.trace_out) {
+        if (auto saved = bench::write_trace(args.trace_out, trace); !saved) {
+            std::print("Trace Error: {}\n", saved.error());
+            return 1;
+        }
+    }
 
-    // Dump logs
-    telemetry::global_logger.dump_blocking();
+    std::print("Trace: {} arrivals over {:.3f}s, {} tenants\n",
+        trace.records.size(), trace.span_ns() / 1e9, trace.tenants.size());
+    auto result = bench::replay(trace, args.opt);
+    bench::print_report(trace, result);
+    return 0;
 }
 
-int main() {
+int main(int argc, char** argv) {
     std::print("Scheduler Simulation [C++23]\n");
     std::print("Feature Set: HWFQ, PIP, CoDel, Lock-free Telemetry\n");
+
+    // --sharded:  per-core run queues with work stealing
+    // --batch N:  generator submits in batches of N via submit_batch()
+    // --measured: charge vruntime with measured run time instead of the estimate
+    // --eevdf:    pick tenants by earliest eligible virtual deadline
+    // --numa:     pin workers and keep tenants on their home node's shards
+    // --nodes N:  model N NUMA nodes instead of reading /sys (never pins)
+    //
+    // --bench:    run the benchmark harness instead of the demo simulation
+    //   --trace FILE       replay a recorded trace (default: synthesize one)
+    //   --save-trace FILE  write the trace used for this run
+    //   --virtual          virtual-time replay (deterministic, no spinning)
+    //   --rate R           mean arrivals/sec (rescales a recorded trace)
+    //   --snapshots FILE   live snapshot every 100ms (JSON lines; binary if FILE ends in .bin)
+    //   --seed S, --duration-ms D, --cores N, --admit-rate R, --task-capacity N
+    SimOptions opt;
+    BenchArgs bench_args;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--sharded") opt.mode = DispatchMode::SHARDED;
+        else if (arg == "--batch" && has_value) opt.batch = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--measured") opt.accounting = VruntimeAccounting::MEASURED;
+        else if (arg == "--eevdf") opt.picker = TenantPicker::EEVDF;
+        else if (arg == "--numa") opt.numa_aware = true;
+        else if (arg == "--nodes" && has_value) opt.numa_nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--bench") bench_args.enabled = true;
+        else if (arg == "--virtual") bench_args.opt.execution = ExecutionModel::VIRTUAL;
+        else if (arg == "--trace" && has_value) bench_args.trace_in = argv[++i];
+        else if (arg == "--save-trace" && has_value) bench_args.trace_out = argv[++i];
+        else if (arg == "--snapshots" && has_value) bench_args.opt.snapshot_path = argv[++i];
+        else if (arg == "--rate" && has_value) bench_args.rate = std::strtod(argv[++i], nullptr);
+        else if (arg == "--seed" && has_value) bench_args.synth.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--duration-ms" && has_value) bench_args.synth.duration_ns = std::strtoull(argv[++i], nullptr, 10) * 1'000'000;
+        else if (arg == "--cores" && has_value) bench_args.opt.cores = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--admit-rate" && has_value) bench_args.opt.base_rate = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--task-capacity" && has_value) bench_args.opt.task_capacity = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    }
+
+    if (bench_args.enabled) {
+        bench_args.opt.mode = opt.mode;
+        bench_args.opt.accounting = opt.accounting;
+        bench_args.opt.picker = opt.picker;
+        bench_args.opt.numa_aware = opt.numa_aware;
+        bench_args.opt.numa_nodes = opt.numa_nodes;
+        return run_benchmark(bench_args);
+    }
     
+    // Telemetry streams to disk while the simulation runs
+    constexpr const char* telemetry_path = "scheduler_telemetry.log";
+    bool streaming = telemetry::global_logger.start_drain(telemetry_path);
+
     try {
-        run_simulation();
+        run_simulation(opt);
     } catch (const std::exception& e) {
         std::print("Fatal Error: {}\n", e.what());
     }
 
+    if (streaming) {
+        telemetry::global_logger.stop_drain();
+        std::print("Telemetry written to {} ({} events dropped)\n",
+            telemetry_path, telemetry::global_logger.dropped());
+    } else {
+        telemetry::global_logger.dump_blocking();
+    }
+
     return 0;
 }
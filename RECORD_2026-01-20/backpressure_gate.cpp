@@ -17,18 +17,23 @@
 // KEY FEATURES:
 // 1. Lock-Free/Fine-Grained Locking queues for 4 priority levels.
 // 2. Thread-safe Asynchronous Logger (Double Buffering).
-// 3. Latency Histogram (P50, P99 calculation).
-// 4. Circuit Breaker pattern for overload protection.
-// 5. Zero-allocation hot paths where possible.
+// 3. Latency Histogram (log-linear HDR, sharded per thread, P50/P99/P99.9).
+// 4. Circuit Breakers per downstream (sharded sliding window) for overload protection.
+// 5. Zero-allocation item path (inline metadata; see --bench-alloc).
+// 6. Hierarchical timer wheel: async IO completions and breaker resets.
+// 7. Calibrated TSC clock plus a 100us coarse clock for timestamps (see --bench-clock).
 // ============================================================================
 
 #include <algorithm>
 #include <atomic>
 #include <array>
 #include <barrier>
+#include <bit>
 #include <chrono>
 #include <cmath>
 #include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <deque>
 #include <format>
 #include <functional>
@@ -38,19 +43,27 @@
 #include <list>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <numeric>
 #include <optional>
 #include <random>
 #include <semaphore>
 #include <source_location>
+#include <span>
 #include <stop_token>
 #include <string>
 #include <string_view>
 #include <syncstream>
 #include <thread>
+#include <type_traits>
 #include <vector>
 #include <variant>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
 // ============================================================================
 // SECTION 1: CORE UTILITIES & TYPES
 // ============================================================================
@@ -60,22 +73,162 @@ using Nanoseconds = std::chrono::nanoseconds;
 using Microseconds = std::chrono::microseconds;
 using Milliseconds = std::chrono::milliseconds;
 
+// --- Heap Allocation Counter ---
+// Global operator new is replaced so --bench-alloc can count allocations on
+// the item path. Counting is off unless the benchmark switches it on: a
+// normal run pays one relaxed load of a never-written flag per allocation,
+// and the shared counter's cache line is only touched inside the window.
+alignas(64) inline std::atomic<bool> g_count_allocations{false};
+alignas(64) inline std::atomic<uint64_t> g_heap_allocations{0};
+
+static inline void note_allocation() {
+    if (g_count_allocations.load(std::memory_order_relaxed)) [[unlikely]] {
+        g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void* operator new(std::size_t size) {
+    note_allocation();
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    note_allocation();
+    auto a = static_cast<std::size_t>(align);
+    if (void* p = std::aligned_alloc(a, (std::max<std::size_t>(size, 1) + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+
+// Kept out of line: once inlined, GCC pairs the free() with the new
+// expression and misreports -Wmismatched-new-delete.
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+// --- Time Helpers ---
+// TscClock reads the invariant TSC and scales it to nanoseconds with a
+// fixed-point multiplier calibrated against steady_clock at startup, so a
+// timestamp is an rdtsc and a multiply instead of a clock_gettime call.
+// Readings share steady_clock's epoch and mix with Clock::now() values up
+// to calibration drift (~10us/s). Without an invariant TSC, or off x86, it
+// falls back to steady_clock.
+class TscClock {
+public:
+    static uint64_t now_ns() {
+        const TscClock& c = instance();
+        if (!c.use_tsc_) [[unlikely]] return steady_ns();
+        auto delta = static_cast<int64_t>(read_tsc() - c.base_tsc_); // Signed: tolerates small cross-core skew
+        return c.base_ns_ + static_cast<uint64_t>((static_cast<__int128>(delta) * c.mult_) >> SHIFT);
+    }
+
+    static bool uses_tsc() { return instance().use_tsc_; }
+    static double ghz() { return instance().use_tsc_ ? double(uint64_t{1} << SHIFT) / double(instance().mult_) : 0.0; }
+
+private:
+    static constexpr int SHIFT = 32;
+    static constexpr uint64_t CALIBRATION_NS = 10'000'000;
+
+    TscClock() : use_tsc_(invariant_tsc()) {
+        if (!use_tsc_) return;
+        uint64_t t0 = steady_ns(), c0 = read_tsc();
+        std::this_thread::sleep_for(Nanoseconds(CALIBRATION_NS));
+        uint64_t t1 = steady_ns(), c1 = read_tsc();
+        if (c1 <= c0 || t1 <= t0) {
+            use_tsc_ = false;
+            return;
+        }
+        mult_ = ((t1 - t0) << SHIFT) / (c1 - c0);
+        base_tsc_ = c1;
+        base_ns_ = t1;
+    }
+
+    static const TscClock& instance() {
+        static const TscClock clock;
+        return clock;
+    }
+
+    static uint64_t steady_ns() {
+        return std::chrono::duration_cast<Nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    static uint64_t read_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    // CPUID 0x80000007 EDX bit 8: the TSC ticks at a constant rate in all
+    // P- and C-states
+    static bool invariant_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+        return (edx >> 8) & 1;
+#else
+        return false;
+#endif
+    }
+
+    bool use_tsc_;
+    uint64_t mult_ = 0;     // ns per tick << SHIFT
+    uint64_t base_tsc_ = 0;
+    uint64_t base_ns_ = 0;
+};
+
+// CoarseClock: a ticker thread publishes TscClock::now_ns() every 100us, and
+// a read is one relaxed load. For timestamps that tolerate that staleness:
+// IDs, breaker window buckets, starvation ages, producer run deadlines.
+class CoarseClock {
+public:
+    static constexpr uint64_t RESOLUTION_NS = 100'000;
+
+    static uint64_t now_ns() { return instance().now_.load(std::memory_order_relaxed); }
+
+private:
+    CoarseClock()
+        : now_(TscClock::now_ns()),
+          ticker_([this](std::stop_token stop) {
+              while (!stop.stop_requested()) {
+                  std::this_thread::sleep_for(Nanoseconds(RESOLUTION_NS));
+                  now_.store(TscClock::now_ns(), std::memory_order_relaxed);
+              }
+          }) {}
+
+    static CoarseClock& instance() {
+        static CoarseClock clock;
+        return clock;
+    }
+
+    alignas(64) std::atomic<uint64_t> now_;
+    std::jthread ticker_;
+};
+
+static inline uint64_t now_ns() { return TscClock::now_ns(); }
+static inline uint64_t coarse_now_ns() { return CoarseClock::now_ns(); }
+
 // --- ID Generator ---
 struct SnowflakeId {
     static uint64_t generate() {
         static std::atomic<uint64_t> seq{0};
         // Simple composition: Timestamp (44 bits) | Sequence (20 bits)
-        uint64_t ts = std::chrono::duration_cast<Milliseconds>(
-            Clock::now().time_since_epoch()).count();
+        uint64_t ts = coarse_now_ns() / 1'000'000; // Milliseconds: the coarse clock is plenty
         return (ts << 20) | (seq.fetch_add(1, std::memory_order_relaxed) & 0xFFFFF);
     }
 };
 
-// --- Time Helper ---
-static inline uint64_t now_ns() {
-    return std::chrono::duration_cast<Nanoseconds>(
-        Clock::now().time_since_epoch()
-    ).count();
+// --- CPU relax hint for spin-wait loops ---
+static inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
 }
 
 // --- Spinlock (for ultra-low latency critical sections) ---
@@ -207,56 +360,173 @@ private:
 // SECTION 3: METRICS & TELEMETRY
 // ============================================================================
 
-class Histogram {
+// --- HDR Histogram ---
+// Log-linear buckets in the HdrHistogram layout: values up to 2 * 10^digits
+// are exact, and above that every value keeps `digits` significant decimal
+// digits (relative error <= 10^-digits). Recording is a clz, two shifts and
+// one relaxed add into the recorder's shard, with no data-dependent
+// branches; shards are merged only when read. A shard is counts_len words
+// (about 180KB at 1us..1h, 3 digits), so size the shard count to the
+// recording threads, not the machine. Values above the trackable maximum
+// are clamped into the top bucket.
+class HdrHistogram {
 public:
-    Histogram(uint64_t min_val, uint64_t max_val, size_t buckets)
-        : min_val_(min_val), max_val_(max_val), bucket_count_(buckets) {
-        buckets_.resize(bucket_count_, 0);
-        step_ = (max_val - min_val) / bucket_count_;
-        if (step_ == 0) step_ = 1;
-    }
-
-    void record(uint64_t value) {
-        if (value < min_val_) value = min_val_;
-        if (value > max_val_) value = max_val_;
-        size_t idx = (value - min_val_) / step_;
-        if (idx >= bucket_count_) idx = bucket_count_ - 1;
-        
-        // Loose atomicity for speed
-        std::atomic_ref<uint64_t>(buckets_[idx]).fetch_add(1, std::memory_order_relaxed);
-        total_count_.fetch_add(1, std::memory_order_relaxed);
-        sum_.fetch_add(value, std::memory_order_relaxed);
-    }
+    // Bucket geometry, shared by the histogram and its snapshots.
+    struct Layout {
+        int sub_half_magnitude;  // log2(sub_bucket_count / 2)
+        uint64_t sub_half_count;
+        uint64_t sub_mask;       // sub_bucket_count - 1
+        uint64_t highest;        // Largest trackable value
+        size_t counts_len;
+
+        Layout(uint64_t highest_trackable, int significant_digits) {
+            significant_digits = std::clamp(significant_digits, 1, 5);
+            uint64_t single_unit = 2;
+            for (int d = 0; d < significant_digits; ++d) single_unit *= 10;
+            int sub_magnitude = static_cast<int>(std::bit_width(single_unit - 1)); // ceil(log2)
+            sub_half_magnitude = sub_magnitude - 1;
+            sub_half_count = uint64_t{1} << sub_half_magnitude;
+            sub_mask = (uint64_t{1} << sub_magnitude) - 1;
+            highest = std::max(highest_trackable, sub_mask);
+
+            // Bucket b covers [sub_bucket_count << (b - 1), sub_bucket_count << b)
+            size_t buckets = 1;
+            for (uint64_t limit = sub_mask + 1; limit <= highest && limit < (uint64_t{1} << 62); limit <<= 1) ++buckets;
+            counts_len = (buckets + 1) * sub_half_count;
+        }
 
-    uint64_t get_percentile(double p) const {
-        uint64_t count = total_count_.load();
-        if (count == 0) return 0;
-        
-        uint64_t target = static_cast<uint64_t>(count * p);
-        uint64_t current = 0;
-        
-        for (size_t i = 0; i < bucket_count_; ++i) {
-            current += buckets_[i];
-            if (current >= target) {
-                return min_val_ + (i * step_);
+        size_t index_of(uint64_t v) const {
+            v = std::min(v, highest);
+            int bucket = static_cast<int>(std::bit_width(v | sub_mask)) - (sub_half_magnitude + 1);
+            uint64_t sub = v >> bucket;
+            return (static_cast<size_t>(bucket + 1) << sub_half_magnitude) + sub - sub_half_count;
+        }
+
+        uint64_t lowest_equivalent(size_t i) const {
+            int bucket = static_cast<int>(i >> sub_half_magnitude) - 1;
+            uint64_t sub = (i & (sub_half_count - 1)) + sub_half_count;
+            if (bucket < 0) {
+                sub -= sub_half_count;
+                bucket = 0;
             }
+            return sub << bucket;
         }
-        return max_val_;
+
+        uint64_t highest_equivalent(size_t i) const {
+            int bucket = std::max(0, static_cast<int>(i >> sub_half_magnitude) - 1);
+            return lowest_equivalent(i) + (uint64_t{1} << bucket) - 1;
+        }
+    };
+
+    // Merged, immutable view. Subtracting an earlier snapshot of the same
+    // histogram leaves exactly what was recorded in between, which gives
+    // interval percentiles without resetting the live counters.
+    class Snapshot {
+    public:
+        uint64_t count() const { return total_; }
+        uint64_t mean() const { return total_ ? sum_ / total_ : 0; }
+
+        // Highest value equivalent to the q-quantile sample (q in [0, 1])
+        uint64_t percentile(double q) const {
+            if (total_ == 0) return 0;
+            auto rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(total_)));
+            rank = std::max<uint64_t>(rank, 1);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts_.size(); ++i) {
+                seen += counts_[i];
+                if (seen >= rank) return layout_.highest_equivalent(i);
+            }
+            return layout_.highest;
+        }
+
+        uint64_t max() const {
+            for (size_t i = counts_.size(); i-- > 0; ) {
+                if (counts_[i]) return layout_.highest_equivalent(i);
+            }
+            return 0;
+        }
+
+        // In place, so a reused interval buffer never allocates
+        Snapshot& operator-=(const Snapshot& earlier) {
+            for (size_t i = 0; i < counts_.size() && i < earlier.counts_.size(); ++i) counts_[i] -= earlier.counts_[i];
+            total_ -= earlier.total_;
+            sum_ -= earlier.sum_;
+            return *this;
+        }
+
+        Snapshot operator-(const Snapshot& earlier) const {
+            Snapshot d = *this;
+            return d -= earlier;
+        }
+
+    private:
+        friend class HdrHistogram;
+        explicit Snapshot(const Layout& layout) : layout_(layout), counts_(layout.counts_len, 0) {}
+
+        Layout layout_;
+        std::vector<uint64_t> counts_;
+        uint64_t total_{0};
+        uint64_t sum_{0};
+    };
+
+    // shards: one per recording thread; 0 means one per hardware thread
+    HdrHistogram(uint64_t highest_trackable, int significant_digits = 3, size_t shards = 0)
+        : layout_(highest_trackable, significant_digits) {
+        if (shards == 0) shards = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < shards; ++i) shards_.push_back(std::make_unique<Shard>(layout_.counts_len));
+    }
+
+    void record(uint64_t value) { record(value, thread_slot()); }
+
+    // shard_index: the recorder's own index (e.g. worker id), taken % shards
+    void record(uint64_t value, size_t shard_index) {
+        Shard& shard = *shards_[shard_index % shards_.size()];
+        shard.counts[layout_.index_of(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
     }
 
-    uint64_t get_mean() const {
-        uint64_t count = total_count_.load();
-        return count == 0 ? 0 : sum_.load() / count;
+    Snapshot snapshot() const {
+        Snapshot s(layout_);
+        snapshot(s);
+        return s;
     }
 
+    // Merges into `out`, reusing its buffer (no allocation once it has
+    // held a snapshot of this histogram)
+    void snapshot(Snapshot& out) const {
+        out.layout_ = layout_;
+        out.counts_.assign(layout_.counts_len, 0);
+        out.sum_ = 0;
+        for (const auto& shard : shards_) {
+            for (size_t i = 0; i < layout_.counts_len; ++i) {
+                out.counts_[i] += shard->counts[i].load(std::memory_order_relaxed);
+            }
+            out.sum_ += shard->sum.load(std::memory_order_relaxed);
+        }
+        out.total_ = std::accumulate(out.counts_.begin(), out.counts_.end(), uint64_t{0});
+    }
+
+    uint64_t get_percentile(double p) const { return snapshot().percentile(p); }
+    uint64_t get_mean() const { return snapshot().mean(); }
+
 private:
-    uint64_t min_val_;
-    uint64_t max_val_;
-    size_t bucket_count_;
-    uint64_t step_;
-    mutable std::vector<uint64_t> buckets_;
-    std::atomic<uint64_t> total_count_{0};
-    std::atomic<uint64_t> sum_{0};
+    // Each shard is its own allocation, so two threads' hot counters never
+    // share a cache line (bar the array edges).
+    struct alignas(64) Shard {
+        std::unique_ptr<std::atomic<uint64_t>[]> counts;
+        std::atomic<uint64_t> sum{0};
+        explicit Shard(size_t n) : counts(std::make_unique<std::atomic<uint64_t>[]>(n)) {}
+    };
+
+    // Stable per-thread index, handed out round-robin on first use
+    static size_t thread_slot() {
+        static std::atomic<size_t> next{0};
+        thread_local const size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    Layout layout_;
+    std::vector<std::unique_ptr<Shard>> shards_;
 };
 
 struct SystemMetrics {
@@ -266,11 +536,21 @@ struct SystemMetrics {
     std::atomic<uint64_t> tasks_processed{0};
     std::atomic<uint64_t> tasks_failed{0};
     
-    // Latency histogram for end-to-end time (0 to 100ms)
-    Histogram processing_latency_us{0, 100000, 100}; 
+    // End-to-end latency, 1us to 1 hour at 3 significant digits; one shard per recorder
+    HdrHistogram processing_latency_us;
+
+    // recorders: threads that record latency (0: one per hardware thread)
+    explicit SystemMetrics(size_t recorders = 0) : processing_latency_us(3'600'000'000, 3, recorders) {}
     
     // Queue depth tracking
     std::atomic<size_t> current_queue_depth{0};
+
+    // Batched dequeue: items processed = sum of batch sizes
+    std::atomic<uint64_t> dequeue_batches{0};
+
+    // Worker idling: each park/wakeup pair is one futex wait/wake
+    std::atomic<uint64_t> worker_parks{0};
+    std::atomic<uint64_t> worker_wakeups{0};
 };
 
 // ============================================================================
@@ -291,10 +571,46 @@ enum class TaskType {
     ADMINISTRATIVE
 };
 
+inline constexpr size_t TASK_TYPE_COUNT = 3;
+constexpr std::array<const char*, TASK_TYPE_COUNT> task_type_names{
+    "CPU_INTENSIVE", "IO_BOUND", "ADMINISTRATIVE"};
+
+// --- Inline Metadata ---
+// Fixed-capacity text stored inside the item. Keeps WorkItem trivially
+// copyable: creating one never allocates, a move through the router ring is
+// a plain copy, and a drained slot holds nothing alive. Longer text is
+// truncated to N bytes.
+template <size_t N>
+class FixedString {
+    static_assert(N > 0 && N < 256, "length is stored in one byte");
+public:
+    FixedString() = default;
+    FixedString(std::string_view s) { assign(s); }
+
+    FixedString& operator=(std::string_view s) {
+        assign(s);
+        return *this;
+    }
+
+    void assign(std::string_view s) {
+        len_ = static_cast<uint8_t>(std::min(s.size(), N));
+        std::memcpy(data_, s.data(), len_);
+    }
+
+    std::string_view view() const { return {data_, len_}; }
+    size_t size() const { return len_; }
+    bool empty() const { return len_ == 0; }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    char data_[N]{};
+    uint8_t len_ = 0;
+};
+
 struct TaskPayload {
     TaskType type;
     uint32_t complexity_score; // 0-1000
-    std::string metadata;
+    FixedString<47> metadata;  // 48 bytes with the length
 };
 
 struct WorkItem {
@@ -303,6 +619,7 @@ struct WorkItem {
     uint64_t created_at_ns;
     TaskPayload payload;
     uint32_t producer_id;
+    uint32_t breaker_generation; // Set by submit: the breaker generation it was admitted in
 
     // Helper to calculate age
     uint64_t age_us() const {
@@ -310,31 +627,218 @@ struct WorkItem {
     }
 };
 
+static_assert(std::is_trivially_copyable_v<WorkItem>, "WorkItem must stay allocation-free");
+
 // ============================================================================
 // SECTION 5: MULTI-LEVEL PRIORITY QUEUE
 // ============================================================================
 
+// --- Bounded MPMC Ring (Vyukov) ---
+// Each cell carries a sequence number saying whose turn it is. A producer
+// claims position p with a CAS on tail_ once cell p has seq == p, writes the
+// value, then publishes seq = p + 1. A consumer claims p with a CAS on head_
+// once seq == p + 1, moves the value out, then hands the cell to the next
+// lap with seq = p + capacity. Producers only contend with producers on
+// tail_, consumers with consumers on head_; nobody waits for a lock holder.
+//
+// Capacity is exact rather than rounded to a power of two: it is the
+// backpressure threshold, so the cell index is pos % capacity. It is at
+// least 2: with a single cell, a published item's seq (p + 1) is also the
+// seq the next producer waits for, so a second push would overwrite it.
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t cap)
+        : capacity_(std::max<size_t>(cap, 2)), cells_(std::make_unique<Cell[]>(capacity_)) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool try_push(T&& item) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos % capacity_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(item);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Full: the cell still holds the previous lap's item
+            } else {
+                pos = tail_.load(std::memory_order_relaxed); // Lost a race; reload
+            }
+        }
+    }
+
+    std::optional<T> pop() {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos % capacity_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    T item = std::move(cell.value);
+                    cell.seq.store(pos + capacity_, std::memory_order_release);
+                    return item;
+                }
+            } else if (diff < 0) {
+                return std::nullopt; // Empty (or the next item is still being written)
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Claims up to out.size() consecutive published items with a single CAS
+    // on head_: the cells are checked first (seq == p + 1 marks a published
+    // item of exactly this lap), then the whole run is taken at once.
+    size_t pop_batch(std::span<T> out) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            size_t ready = 0;
+            while (ready < out.size() && ready < capacity_ &&
+                   cells_[(pos + ready) % capacity_].seq.load(std::memory_order_acquire) == pos + ready + 1) {
+                ++ready;
+            }
+            if (ready == 0) {
+                size_t current = head_.load(std::memory_order_relaxed);
+                if (current == pos) return 0; // Empty (or the next item is still being written)
+                pos = current;
+                continue;
+            }
+            if (head_.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed)) {
+                for (size_t k = 0; k < ready; ++k) {
+                    Cell& cell = cells_[(pos + k) % capacity_];
+                    out[k] = std::move(cell.value);
+                    cell.seq.store(pos + k + capacity_, std::memory_order_release);
+                }
+                return ready;
+            }
+        }
+    }
+
+    // Approximate under concurrency; never exceeds capacity.
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        return tail > head ? std::min(tail - head, capacity_) : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    const size_t capacity_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> tail_{0}; // Next position to write
+    alignas(64) std::atomic<size_t> head_{0}; // Next position to read
+};
+
+// --- Spinlock Ring ---
+// The original router queue, kept as the baseline for the queue benchmark.
+template <typename T>
+class SpinLockRing {
+public:
+    explicit SpinLockRing(size_t cap) 
+        : capacity_(cap), head_(0), tail_(0), size_(0) {
+        buffer_.resize(cap);
+    }
+
+    bool try_push(T&& item) {
+        std::lock_guard<SpinLock> lock(lock_);
+        if (size_.load(std::memory_order_relaxed) >= capacity_) return false;
+        
+        buffer_[tail_] = std::move(item);
+        tail_ = (tail_ + 1) % capacity_;
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    std::optional<T> pop() {
+        // Optimistic check before lock
+        if (size_.load(std::memory_order_relaxed) == 0) return std::nullopt; 
+
+        std::lock_guard<SpinLock> lock(lock_);
+        if (size_.load(std::memory_order_relaxed) == 0) return std::nullopt;
+
+        T item = std::move(buffer_[head_]);
+        head_ = (head_ + 1) % capacity_;
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return item;
+    }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    size_t capacity_;
+    std::vector<T> buffer_;
+    size_t head_;
+    size_t tail_;
+    std::atomic<size_t> size_; // Atomic so the unlocked emptiness check is not a data race
+    SpinLock lock_;
+};
+
+// --- Dequeue Discipline ---
+// CRITICAL is served first under every discipline (the fast path); the
+// discipline decides how HIGH, NORMAL and LOW share what is left.
+enum class DequeueDiscipline : uint8_t {
+    STRICT,    // HIGH, then NORMAL, then LOW: lower classes can starve
+    WRR,       // Weighted round robin: weights[c] items per turn
+    DRR,       // Deficit round robin: weights[c] * DRR_QUANTUM cost units per turn (cost-fair)
+    AGE_BOOST  // Strict, but a class left waiting past max_class_wait_us goes first
+};
+
+struct DequeuePolicy {
+    DequeueDiscipline discipline = DequeueDiscipline::STRICT;
+    std::array<uint32_t, 4> weights{0, 4, 2, 1}; // HIGH:NORMAL:LOW = 4:2:1; [0] unused
+    uint64_t max_class_wait_us = 20'000;         // AGE_BOOST starvation bound
+};
+
 class PriorityRouter {
 public:
-    explicit PriorityRouter(size_t base_capacity) {
+    static constexpr int64_t DRR_QUANTUM = 500; // Cost units (complexity_score + 1) per weight
+
+    // Round-robin position of one consumer. Each worker keeps its own, so
+    // WRR/DRR need no shared state: every worker's dequeues follow the
+    // weights, and therefore so does their sum.
+    struct ConsumerState {
+        size_t turn = 1;                    // Class whose turn it is (1..3)
+        bool granted = false;               // Quantum already added for this turn
+        std::array<int64_t, 4> deficit{};  // Credit left per class
+    };
+
+    explicit PriorityRouter(size_t base_capacity, DequeuePolicy policy = {})
+        : policy_(policy) {
         // Configure capacities based on priority logic
         // Critical queue is smaller but higher priority
         queues_[0] = std::make_unique<BoundedQueue>(base_capacity / 4); // Critical
         queues_[1] = std::make_unique<BoundedQueue>(base_capacity / 2); // High
         queues_[2] = std::make_unique<BoundedQueue>(base_capacity);     // Normal
         queues_[3] = std::make_unique<BoundedQueue>(base_capacity * 2); // Low
+        for (auto& w : policy_.weights) w = std::max<uint32_t>(w, 1); // Zero would never be served
+        uint64_t now = coarse_now_ns();
+        for (auto& t : waiting_since_ns_) t.store(now, std::memory_order_relaxed);
     }
 
     // Returns true if enqueued, false if full
     bool try_push(WorkItem&& item) {
         int prio_idx = static_cast<int>(item.priority);
-        bool success = queues_[prio_idx]->try_push(std::move(item));
-        
-        if (success) {
-             // Signal that work is available
-             total_items_.fetch_add(1, std::memory_order_release);
-             return true;
-        }
+
+        // Count the item before it becomes visible: a consumer may pop it the
+        // moment the cell is published, and its batch fetch_sub must never
+        // run ahead of this add (the unsigned counter would wrap).
+        total_items_.fetch_add(1, std::memory_order_release);
+        if (queues_[prio_idx]->try_push(std::move(item))) return true;
+
+        total_items_.fetch_sub(1, std::memory_order_relaxed); // Full: never published
         return false;
     }
 
@@ -349,12 +853,47 @@ public:
             auto item = queues_[i]->pop();
             if (item.has_value()) {
                 total_items_.fetch_sub(1, std::memory_order_release);
+                dequeued_[i].fetch_add(1, std::memory_order_relaxed);
                 return item;
             }
         }
         return std::nullopt;
     }
 
+    // Batch form of try_pop under the configured discipline: CRITICAL is
+    // drained first, then the rest of `out` is filled by the discipline.
+    // One claim per queue visited and one total_items_ update per batch.
+    size_t try_pop_batch(std::span<WorkItem> out, ConsumerState& consumer) {
+        if (total_items_.load(std::memory_order_acquire) == 0) {
+            return 0;
+        }
+
+        size_t taken = drain(0, out);
+        switch (policy_.discipline) {
+            case DequeueDiscipline::STRICT:
+                for (size_t c = 1; c < QUEUES && taken < out.size(); ++c) taken += drain(c, out.subspan(taken));
+                break;
+            case DequeueDiscipline::AGE_BOOST:
+                taken += take_age_boosted(out.subspan(taken));
+                break;
+            case DequeueDiscipline::WRR:
+            case DequeueDiscipline::DRR:
+                taken += take_round_robin(out.subspan(taken), consumer);
+                break;
+        }
+        if (taken > 0) total_items_.fetch_sub(taken, std::memory_order_release);
+        return taken;
+    }
+
+    // Items handed out per priority since start
+    std::array<uint64_t, 4> dequeued() const {
+        std::array<uint64_t, 4> out{};
+        for (size_t c = 0; c < QUEUES; ++c) out[c] = dequeued_[c].load(std::memory_order_relaxed);
+        return out;
+    }
+
+    const DequeuePolicy& policy() const { return policy_; }
+
     size_t total_size() const {
         return total_items_.load(std::memory_order_relaxed);
     }
@@ -364,156 +903,754 @@ public:
     }
 
 private:
-    // --- Internal Bounded Queue Class ---
-    // (Nested to ensure it's only used by Router)
-    class BoundedQueue {
-    public:
-        explicit BoundedQueue(size_t cap) 
-            : capacity_(cap), head_(0), tail_(0), size_(0) {
-            buffer_.resize(cap);
+    using BoundedQueue = MpmcRing<WorkItem>;
+    static constexpr size_t QUEUES = static_cast<size_t>(Priority::COUNT);
+
+    // Up to out.size() items from class c, in as many ring claims as it
+    // takes (a wrapped or partially published run comes back in pieces).
+    size_t drain(size_t c, std::span<WorkItem> out) {
+        size_t taken = 0;
+        size_t n;
+        while (taken < out.size() && (n = queues_[c]->pop_batch(out.subspan(taken))) > 0) {
+            taken += n;
         }
+        if (taken > 0) dequeued_[c].fetch_add(taken, std::memory_order_relaxed);
+        return taken;
+    }
 
-        bool try_push(WorkItem&& item) {
-            std::lock_guard<SpinLock> lock(lock_);
-            if (size_ >= capacity_) return false;
-            
-            buffer_[tail_] = std::move(item);
-            tail_ = (tail_ + 1) % capacity_;
-            size_++;
-            return true;
+    // A class "waits" from the last time it was served or seen empty. Any
+    // class waiting longer than the bound is drained first, longest first;
+    // the remainder of the batch is strict.
+    size_t take_age_boosted(std::span<WorkItem> out) {
+        uint64_t now = coarse_now_ns(); // The bound is in milliseconds
+        uint64_t bound_ns = policy_.max_class_wait_us * 1000;
+        std::array<size_t, 3> order{1, 2, 3};
+        std::ranges::stable_sort(order, std::greater<>{}, [&](size_t c) {
+            // Another consumer may have stored a newer coarse reading than ours
+            uint64_t since = waiting_since_ns_[c].load(std::memory_order_relaxed);
+            uint64_t waited = now > since ? now - since : 0;
+            return waited > bound_ns ? waited : 0; // Not starved: keep strict order
+        });
+
+        size_t taken = 0;
+        for (size_t c : order) {
+            size_t n = taken < out.size() ? drain(c, out.subspan(taken)) : 0;
+            taken += n;
+            if (n > 0 || queues_[c]->size() == 0) waiting_since_ns_[c].store(now, std::memory_order_relaxed);
         }
+        return taken;
+    }
 
-        std::optional<WorkItem> pop() {
-            // Optimistic check before lock
-            if (size_ == 0) return std::nullopt; 
+    // WRR and DRR share the loop: a turn grants class c a quantum of credit,
+    // each dequeued item costs 1 (WRR) or complexity_score + 1 (DRR), and
+    // the turn passes on when the credit is spent or the class runs dry
+    // (unused credit is not banked). Overspending in DRR carries over as debt.
+    size_t take_round_robin(std::span<WorkItem> out, ConsumerState& cs) {
+        const bool by_cost = policy_.discipline == DequeueDiscipline::DRR;
+        size_t taken = 0;
+        for (size_t empty_turns = 0; taken < out.size() && empty_turns < QUEUES - 1; ) {
+            size_t c = cs.turn;
+            if (!cs.granted) {
+                cs.deficit[c] += static_cast<int64_t>(policy_.weights[c]) * (by_cost ? DRR_QUANTUM : 1);
+                cs.granted = true;
+            }
 
-            std::lock_guard<SpinLock> lock(lock_);
-            if (size_ == 0) return std::nullopt;
+            size_t got = 0;
+            while (cs.deficit[c] > 0 && taken < out.size()) {
+                size_t want = by_cost ? 1 : std::min(out.size() - taken, static_cast<size_t>(cs.deficit[c]));
+                size_t n = queues_[c]->pop_batch(out.subspan(taken, want));
+                if (n == 0) {
+                    cs.deficit[c] = 0; // Ran dry
+                    break;
+                }
+                for (size_t k = 0; k < n; ++k) {
+                    cs.deficit[c] -= by_cost ? out[taken + k].payload.complexity_score + 1 : 1;
+                }
+                taken += n;
+                got += n;
+            }
+            if (got > 0) dequeued_[c].fetch_add(got, std::memory_order_relaxed);
 
-            WorkItem item = std::move(buffer_[head_]);
-            head_ = (head_ + 1) % capacity_;
-            size_--;
-            return item;
+            if (cs.deficit[c] <= 0) {
+                cs.turn = c + 1 < QUEUES ? c + 1 : 1;
+                cs.granted = false;
+            }
+            empty_turns = got > 0 ? 0 : empty_turns + 1;
         }
+        return taken;
+    }
 
-        size_t size() const { return size_; }
-
-    private:
-        size_t capacity_;
-        std::vector<WorkItem> buffer_;
-        size_t head_;
-        size_t tail_;
-        size_t size_;
-        SpinLock lock_;
-    };
-
+    DequeuePolicy policy_;
     std::array<std::unique_ptr<BoundedQueue>, 4> queues_;
     std::atomic<size_t> total_items_{0};
+    std::array<std::atomic<uint64_t>, 4> dequeued_{};
+    std::array<std::atomic<uint64_t>, 4> waiting_since_ns_{}; // AGE_BOOST only
 };
 
 // ============================================================================
-// SECTION 6: CIRCUIT BREAKER
+// SECTION 6: TIMERS & CIRCUIT BREAKER
 // ============================================================================
 
-class CircuitBreaker {
+// --- Hierarchical Timer Wheel ---
+// Four levels of 64 slots; level l slot s holds timers due in the tick
+// window that maps to s once the tick is shifted right by 6 * l. Timers are
+// intrusive (owners derive from Timer), so schedule and cancel are a list
+// link/unlink under a spinlock: O(1), no allocation. A dedicated thread
+// advances the wheel, re-placing (cascading) a higher-level slot whenever
+// the level below wraps, and fires everything in the current level-0 slot
+// as one batch outside the lock. Per-level occupancy bitmaps let the
+// thread sleep straight to the next occupied level-0 slot or the next
+// cascade, and indefinitely while the wheel is empty. Timers fire on the
+// first tick at or after their deadline, never early; deadlines past the
+// wheel's span (64^4 ticks) are re-placed until they are in range.
+class TimerWheel {
 public:
-    enum class State { CLOSED, OPEN, HALF_OPEN };
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+    static constexpr uint64_t NO_TICK = std::numeric_limits<uint64_t>::max();
 
-    CircuitBreaker(double failure_threshold, uint64_t reset_timeout_ms)
-        : failure_threshold_(failure_threshold), 
-          reset_timeout_ms_(reset_timeout_ms),
-          state_(State::CLOSED),
-          failures_(0),
-          total_(0) {}
+    class Timer {
+    public:
+        virtual ~Timer() = default;
+        bool armed() const { return armed_; } // Only stable under the owner's own synchronization
 
-    bool allow_request() {
-        State current = state_.load(std::memory_order_acquire);
-        
-        if (current == State::OPEN) {
-            uint64_t now = now_ns();
-            if (now > next_try_timestamp_.load()) {
-                // Time to try Half-Open
-                if (state_.compare_exchange_strong(current, State::HALF_OPEN)) {
-                    LOG_WARN("Circuit Breaker entering HALF_OPEN state");
-                    return true; // Allow one probe request
-                }
+    protected:
+        // Runs on the wheel thread, after the timer has been disarmed; may re-schedule it
+        virtual void on_expire() = 0;
+
+    private:
+        friend class TimerWheel;
+        Timer* prev_ = nullptr;
+        Timer* next_ = nullptr;
+        uint64_t deadline_tick_ = 0;
+        uint8_t level_ = 0;
+        uint8_t slot_ = 0;
+        bool armed_ = false;
+    };
+
+    explicit TimerWheel(uint64_t tick_ns = 100'000)
+        : tick_ns_(std::max<uint64_t>(tick_ns, 1)), current_tick_(now_ns() / tick_ns_) {
+        for (auto& level : slots_) {
+            for (auto& head : level) head.prev_ = head.next_ = &head;
+        }
+        firing_.reserve(1024);
+        thread_ = std::thread(&TimerWheel::run, this);
+    }
+
+    ~TimerWheel() { stop(); }
+
+    // Arms (or re-arms) t to fire at deadline_ns; a past deadline fires on the next tick
+    void schedule(Timer& t, uint64_t deadline_ns) {
+        uint64_t deadline_tick = (deadline_ns + tick_ns_ - 1) / tick_ns_;
+        bool kick;
+        {
+            std::lock_guard<SpinLock> lock(lock_);
+            if (t.armed_) {
+                unlink(t);
+            } else {
+                // An empty wheel's thread is asleep and its tick is stale
+                if (armed_count_ == 0) current_tick_ = std::max(current_tick_, now_ns() / tick_ns_);
+                ++armed_count_;
+                t.armed_ = true;
             }
-            return false;
+            t.deadline_tick_ = deadline_tick;
+            place(t);
+            kick = deadline_tick < wake_tick_;
         }
+        if (kick) wake_thread();
+    }
+
+    // True if t was armed and will not fire. False means it already fired
+    // or is firing right now.
+    bool cancel(Timer& t) {
+        std::lock_guard<SpinLock> lock(lock_);
+        if (!t.armed_) return false;
+        unlink(t);
+        t.armed_ = false;
+        --armed_count_;
         return true;
     }
 
-    void record_result(bool success) {
-        if (state_.load() == State::OPEN) return;
+    // Joins the wheel thread; timers still armed are dropped without firing
+    void stop() {
+        if (stopping_.exchange(true)) return;
+        wake_thread();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    uint64_t tick_ns() const { return tick_ns_; }
+
+    size_t armed_count() const {
+        std::lock_guard<SpinLock> lock(lock_);
+        return armed_count_;
+    }
+
+private:
+    // Slot heads are bare sentinels: only their links are used
+    struct Head final : Timer {
+        void on_expire() override {}
+    };
+
+    void run() {
+        while (!stopping_.load(std::memory_order_relaxed)) {
+            uint64_t wake_tick;
+            {
+                std::lock_guard<SpinLock> lock(lock_);
+                advance(now_ns() / tick_ns_);
+                wake_tick = wake_tick_ = next_event_tick();
+            }
+            for (Timer* t : firing_) t->on_expire();
+            firing_.clear();
 
-        if (state_.load() == State::HALF_OPEN) {
-            if (success) {
-                reset();
-                LOG_INFO("Circuit Breaker CLOSED (Recovered)");
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            auto woken = [this] { return kicked_ || stopping_.load(std::memory_order_relaxed); };
+            if (wake_tick == NO_TICK) {
+                sleep_cv_.wait(lock, woken);
             } else {
-                trip(); // Back to open
+                uint64_t now = now_ns();
+                uint64_t wake_ns = wake_tick * tick_ns_;
+                if (wake_ns > now) sleep_cv_.wait_for(lock, Nanoseconds(wake_ns - now), woken);
             }
+            kicked_ = false;
+        }
+    }
+
+    void wake_thread() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            kicked_ = true;
+        }
+        sleep_cv_.notify_one();
+    }
+
+    // Moves the wheel up to now_tick, collecting due timers into firing_
+    void advance(uint64_t now_tick) {
+        if (armed_count_ == 0) {
+            current_tick_ = std::max(current_tick_, now_tick);
             return;
         }
+        while (current_tick_ < now_tick) {
+            ++current_tick_;
+            uint64_t index = current_tick_ & SLOT_MASK;
+            if (index == 0) cascade(1);
+
+            Timer& head = slots_[0][index];
+            while (head.next_ != &head) {
+                Timer& t = *head.next_;
+                unlink(t);
+                if (t.deadline_tick_ <= current_tick_) {
+                    t.armed_ = false;
+                    --armed_count_;
+                    firing_.push_back(&t);
+                } else {
+                    place(t); // Was beyond the wheel's span
+                }
+            }
+        }
+    }
 
-        // CLOSED State logic
-        total_.fetch_add(1, std::memory_order_relaxed);
-        if (!success) {
-            failures_.fetch_add(1, std::memory_order_relaxed);
+    // Re-places the slot of `level` that the current tick has just reached.
+    // Higher levels go first so their timers can land in this level's slot.
+    void cascade(int level) {
+        uint64_t index = (current_tick_ >> (SLOT_BITS * level)) & SLOT_MASK;
+        if (index == 0 && level + 1 < LEVELS) cascade(level + 1);
+
+        Timer& head = slots_[level][index];
+        while (head.next_ != &head) {
+            Timer& t = *head.next_;
+            unlink(t);
+            place(t);
         }
+    }
 
-        // Check threshold periodically (e.g., every 100 requests) to avoid math overhead
-        if (total_.load() > 100) {
-            double rate = static_cast<double>(failures_.load()) / total_.load();
-            if (rate > failure_threshold_) {
-                trip();
-            } else {
-                // Decay metrics
-                failures_.store(0);
-                total_.store(0);
+    void place(Timer& t) {
+        uint64_t tick = std::max(t.deadline_tick_, current_tick_ + 1);
+        uint64_t delta = std::min<uint64_t>(tick - current_tick_, (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1);
+        tick = current_tick_ + delta;
+        int level = std::min(static_cast<int>(std::bit_width(delta) - 1) / SLOT_BITS, LEVELS - 1);
+        auto slot = static_cast<uint8_t>((tick >> (SLOT_BITS * level)) & SLOT_MASK);
+
+        Timer& head = slots_[level][slot];
+        t.prev_ = head.prev_;
+        t.next_ = &head;
+        head.prev_->next_ = &t;
+        head.prev_ = &t;
+        t.level_ = static_cast<uint8_t>(level);
+        t.slot_ = slot;
+        occupied_[level] |= uint64_t{1} << slot;
+    }
+
+    void unlink(Timer& t) {
+        t.prev_->next_ = t.next_;
+        t.next_->prev_ = t.prev_;
+        t.prev_ = t.next_ = nullptr;
+        Timer& head = slots_[t.level_][t.slot_];
+        if (head.next_ == &head) occupied_[t.level_] &= ~(uint64_t{1} << t.slot_);
+    }
+
+    // Next tick worth waking for: the next occupied level-0 slot in this
+    // rotation, else the level-0 wrap (where higher levels cascade)
+    uint64_t next_event_tick() const {
+        if (armed_count_ == 0) return NO_TICK;
+        uint64_t index = current_tick_ & SLOT_MASK;
+        uint64_t ahead = index + 1 < SLOTS ? occupied_[0] >> (index + 1) : 0;
+        if (ahead) return current_tick_ + 1 + static_cast<uint64_t>(std::countr_zero(ahead));
+        return current_tick_ + (SLOTS - index);
+    }
+
+    uint64_t tick_ns_;
+    mutable SpinLock lock_;                       // Guards everything down to wake_tick_
+    std::array<std::array<Head, SLOTS>, LEVELS> slots_;
+    std::array<uint64_t, LEVELS> occupied_{};     // Bit s: slot s is non-empty
+    uint64_t current_tick_;                       // Last tick processed
+    size_t armed_count_ = 0;
+    uint64_t wake_tick_ = NO_TICK;                // When the thread plans to wake
+
+    std::vector<Timer*> firing_;                  // Wheel thread only
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    bool kicked_ = false;                         // Guarded by sleep_mutex_
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+// Failure rate over a sliding window, kept in per-worker shards so the
+// success path touches only the recording worker's cache line. Each shard
+// holds a ring of time buckets tagged with their epoch; a stale bucket is
+// recycled by whoever lands in it next, and readers skip buckets older
+// than the window. The summed rate is only evaluated on failures (a
+// success cannot raise it), and once the window holds min_requests, at
+// most once per EVAL_INTERVAL_NS.
+//
+// CLOSED:    admit() is a single relaxed load.
+// OPEN:      everything is rejected until reset_timeout_ms has passed. With
+//            a TimerWheel the wheel flips the state, so OPEN is one load
+//            too; without one, OPEN compares the clock on each call.
+// HALF_OPEN: exactly half_open_probes requests are admitted; that many
+//            successes close the breaker, any failure reopens it. A probe
+//            that never reached the downstream (queue full) is handed back
+//            with refund_probe(); one that was lost outright is covered by
+//            probe_timeout_ms, after which HALF_OPEN without a verdict
+//            reopens too.
+//
+// State and a generation number share one word; every trip starts a new
+// generation. admit() hands out the generation a request was admitted in,
+// and record_result() drops results from earlier generations, so items
+// queued or in flight before a trip never count as probes (or against the
+// recovered window).
+class CircuitBreaker {
+public:
+    enum class State : uint8_t { CLOSED, OPEN, HALF_OPEN };
+
+    struct Config {
+        double failure_threshold = 0.5;  // Trip when failures / total exceeds this
+        uint64_t reset_timeout_ms = 2000; // OPEN -> HALF_OPEN delay
+        uint64_t window_ms = 1000;        // Sliding window length
+        size_t window_buckets = 10;       // Window granularity
+        uint64_t min_requests = 100;      // Volume needed before the rate counts
+        uint32_t half_open_probes = 5;    // Probe budget per HALF_OPEN episode
+        uint64_t probe_timeout_ms = 1000; // HALF_OPEN -> OPEN if the probes have not decided by then
+    };
+
+    static constexpr uint64_t EVAL_INTERVAL_NS = 1'000'000;
+
+    // shards: usually the worker count; record_result maps shard % shards
+    CircuitBreaker(Config config, size_t shards, std::string name = "Circuit Breaker", TimerWheel* timers = nullptr)
+        : config_(config),
+          name_(std::move(name)),
+          timers_(timers),
+          bucket_ns_(std::max<uint64_t>(config.window_ms * 1'000'000 / std::max<size_t>(config.window_buckets, 1), 1)),
+          buckets_per_shard_(std::max<size_t>(config.window_buckets, 1)) {
+        for (size_t i = 0; i < std::max<size_t>(shards, 1); ++i) {
+            shards_.push_back(std::make_unique<Shard>(buckets_per_shard_));
+        }
+        reopen_timer_.owner = this;
+        probe_timer_.owner = this;
+    }
+
+    ~CircuitBreaker() {
+        if (timers_) {
+            timers_->cancel(reopen_timer_);
+            timers_->cancel(probe_timer_);
+        }
+    }
+
+    CircuitBreaker(double failure_threshold, uint64_t reset_timeout_ms, size_t shards = 1)
+        : CircuitBreaker(Config{.failure_threshold = failure_threshold, .reset_timeout_ms = reset_timeout_ms}, shards) {}
+
+    // The generation to pass back to record_result, or nullopt if rejected
+    std::optional<uint32_t> admit() {
+        uint32_t word = word_.load(std::memory_order_relaxed);
+        if (state_of(word) == State::CLOSED) [[likely]] return generation_of(word);
+
+        if (state_of(word) == State::OPEN) {
+            if (timers_ || !reopen_due(word)) {
+                rejections_.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+            enter_half_open(); // No wheel: the first caller past the timeout does it
+        }
+        if (auto generation = take_probe()) return generation;
+        if (!timers_) expire_probes(); // No wheel: rejected callers check the probe deadline
+        rejections_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    // Gives back a probe admit() handed out for `generation` that never
+    // reached the downstream (e.g. the queue was full). A no-op outside
+    // HALF_OPEN or for another generation; racing a trip and a fresh
+    // HALF_OPEN can leave one extra probe, never one too few.
+    void refund_probe(uint32_t generation) {
+        uint32_t word = word_.load(std::memory_order_acquire);
+        if (state_of(word) != State::HALF_OPEN || generation_of(word) != generation) return;
+        probes_left_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_result(size_t shard, bool success, uint32_t generation) {
+        uint32_t word = word_.load(std::memory_order_acquire);
+        if (generation_of(word) != generation) return; // Admitted before the last trip
+        State current = state_of(word);
+        if (current == State::OPEN) return;
+
+        if (current == State::HALF_OPEN) {
+            if (!success) {
+                trip(word);
+            } else if (probe_successes_.fetch_add(1, std::memory_order_relaxed) + 1 >= config_.half_open_probes) {
+                close(word);
             }
+            return;
+        }
+
+        // CLOSED: one relaxed add on this worker's own bucket
+        uint64_t now = coarse_now_ns(); // Buckets are 100ms wide
+        uint64_t epoch = now / bucket_ns_;
+        Bucket& b = shards_[shard % shards_.size()]->buckets[epoch % buckets_per_shard_];
+        uint64_t seen = b.epoch.load(std::memory_order_relaxed);
+        if (seen != epoch && b.epoch.compare_exchange_strong(seen, epoch, std::memory_order_relaxed)) {
+            b.total.store(0, std::memory_order_relaxed);
+            b.failures.store(0, std::memory_order_relaxed);
+        }
+        b.total.fetch_add(1, std::memory_order_relaxed);
+        if (success) return;
+
+        b.failures.fetch_add(1, std::memory_order_relaxed);
+        uint64_t next = next_eval_ns_.load(std::memory_order_relaxed);
+        if (now < next) return;
+
+        auto [total, failures] = window_counts(epoch);
+        if (total < config_.min_requests) return; // Low volume: cheap to re-check on the next failure
+        if (!next_eval_ns_.compare_exchange_strong(next, now + EVAL_INTERVAL_NS, std::memory_order_relaxed)) return;
+        if (static_cast<double>(failures) > config_.failure_threshold * static_cast<double>(total)) {
+            trip(word);
         }
     }
 
+    State state() const { return state_of(word_.load(std::memory_order_relaxed)); }
+    uint32_t generation() const { return generation_of(word_.load(std::memory_order_relaxed)); }
+    uint64_t trips() const { return trips_.load(std::memory_order_relaxed); }
+    uint64_t rejections() const { return rejections_.load(std::memory_order_relaxed); }
+    const Config& config() const { return config_; }
+    const std::string& name() const { return name_; }
+
 private:
-    void trip() {
-        state_.store(State::OPEN, std::memory_order_release);
-        next_try_timestamp_.store(now_ns() + (reset_timeout_ms_ * 1'000'000));
-        LOG_ERR("Circuit Breaker TRIPPED to OPEN state due to high failure rate");
+    struct Bucket {
+        std::atomic<uint64_t> epoch{0};  // now_ns / bucket_ns_ this bucket counts for
+        std::atomic<uint64_t> total{0};
+        std::atomic<uint64_t> failures{0};
+    };
+
+    struct alignas(64) Shard {
+        std::unique_ptr<Bucket[]> buckets;
+        explicit Shard(size_t n) : buckets(std::make_unique<Bucket[]>(n)) {}
+    };
+
+    struct ReopenTimer final : TimerWheel::Timer {
+        CircuitBreaker* owner = nullptr;
+        void on_expire() override { owner->enter_half_open(); }
+    };
+
+    struct ProbeTimer final : TimerWheel::Timer {
+        CircuitBreaker* owner = nullptr;
+        void on_expire() override { owner->expire_probes(); }
+    };
+
+    // word_ layout: generation << 2 | state
+    static State state_of(uint32_t word) { return static_cast<State>(word & 3); }
+    static uint32_t generation_of(uint32_t word) { return word >> 2; }
+    static uint32_t make_word(uint32_t generation, State s) { return generation << 2 | static_cast<uint32_t>(s); }
+
+    // Clock fallback: reopen_at_ns_ is only trusted once it has been
+    // written for the generation that is currently OPEN
+    bool reopen_due(uint32_t word) const {
+        if (reopen_generation_.load(std::memory_order_acquire) != generation_of(word)) return false;
+        return now_ns() >= reopen_at_ns_.load(std::memory_order_relaxed);
     }
 
-    void reset() {
-        state_.store(State::CLOSED, std::memory_order_release);
-        failures_.store(0);
-        total_.store(0);
+    // OPEN -> HALF_OPEN (same generation); the winner opens the probe budget
+    void enter_half_open() {
+        uint32_t word = word_.load(std::memory_order_relaxed);
+        if (state_of(word) != State::OPEN) return;
+        if (word_.compare_exchange_strong(word, make_word(generation_of(word), State::HALF_OPEN),
+                                          std::memory_order_acq_rel)) {
+            probe_successes_.store(0, std::memory_order_relaxed);
+            probes_left_.store(config_.half_open_probes, std::memory_order_release);
+            uint64_t deadline = now_ns() + config_.probe_timeout_ms * 1'000'000;
+            probe_deadline_ns_.store(deadline, std::memory_order_relaxed);
+            probe_generation_.store(generation_of(word), std::memory_order_release);
+            if (timers_) timers_->schedule(probe_timer_, deadline);
+            LOG_WARN(std::format("{} entering HALF_OPEN state", name_));
+        }
     }
 
-    double failure_threshold_;
-    uint64_t reset_timeout_ms_;
-    std::atomic<State> state_;
-    std::atomic<uint64_t> next_try_timestamp_{0};
-    
-    std::atomic<uint64_t> failures_;
-    std::atomic<uint64_t> total_;
+    // Probe timeout: a HALF_OPEN generation still undecided at its deadline
+    // reopens, so probes lost on the way (dropped, never completed) cannot
+    // hold the breaker in HALF_OPEN with an empty budget
+    void expire_probes() {
+        uint32_t word = word_.load(std::memory_order_acquire);
+        if (state_of(word) != State::HALF_OPEN) return;
+        if (probe_generation_.load(std::memory_order_acquire) != generation_of(word)) return;
+        if (!timers_ && now_ns() < probe_deadline_ns_.load(std::memory_order_relaxed)) return;
+        LOG_WARN(std::format("{} HALF_OPEN probes timed out", name_));
+        trip(word);
+    }
+
+    // Totals over buckets inside the window that started after the last close
+    std::pair<uint64_t, uint64_t> window_counts(uint64_t epoch) const {
+        uint64_t oldest = std::max(epoch + 1 - std::min<uint64_t>(epoch + 1, buckets_per_shard_),
+                                   closed_at_epoch_.load(std::memory_order_relaxed));
+        uint64_t total = 0, failures = 0;
+        for (const auto& shard : shards_) {
+            for (size_t i = 0; i < buckets_per_shard_; ++i) {
+                const Bucket& b = shard->buckets[i];
+                uint64_t e = b.epoch.load(std::memory_order_relaxed);
+                if (e < oldest || e > epoch) continue;
+                total += b.total.load(std::memory_order_relaxed);
+                failures += b.failures.load(std::memory_order_relaxed);
+            }
+        }
+        return {total, failures};
+    }
+
+    std::optional<uint32_t> take_probe() {
+        uint32_t word = word_.load(std::memory_order_acquire);
+        if (state_of(word) != State::HALF_OPEN) return std::nullopt;
+        uint32_t left = probes_left_.load(std::memory_order_relaxed);
+        while (left > 0) {
+            if (probes_left_.compare_exchange_weak(left, left - 1, std::memory_order_relaxed)) {
+                return generation_of(word);
+            }
+        }
+        return std::nullopt;
+    }
+
+    // `from` is the word the caller based its decision on. Only the thread
+    // whose CAS wins starts the new generation, arms the timer and logs.
+    void trip(uint32_t from) {
+        uint32_t generation = generation_of(from) + 1;
+        if (!word_.compare_exchange_strong(from, make_word(generation, State::OPEN), std::memory_order_acq_rel)) return;
+
+        uint64_t reopen_at = now_ns() + config_.reset_timeout_ms * 1'000'000;
+        reopen_at_ns_.store(reopen_at, std::memory_order_relaxed);
+        reopen_generation_.store(generation, std::memory_order_release);
+        probes_left_.store(0, std::memory_order_relaxed);
+        trips_.fetch_add(1, std::memory_order_relaxed);
+        if (timers_) {
+            timers_->cancel(probe_timer_);
+            timers_->schedule(reopen_timer_, reopen_at);
+        }
+        LOG_ERR(std::format("{} TRIPPED to OPEN state due to high failure rate", name_));
+    }
+
+    void close(uint32_t from) {
+        // Failures from before the outage must not count against the new window
+        closed_at_epoch_.store(coarse_now_ns() / bucket_ns_ + 1, std::memory_order_relaxed);
+        if (word_.compare_exchange_strong(from, make_word(generation_of(from), State::CLOSED),
+                                          std::memory_order_acq_rel)) {
+            if (timers_) timers_->cancel(probe_timer_);
+            LOG_INFO(std::format("{} CLOSED (Recovered)", name_));
+        }
+    }
+
+    Config config_;
+    std::string name_;
+    TimerWheel* timers_;       // Optional; drives OPEN -> HALF_OPEN
+    ReopenTimer reopen_timer_;
+    ProbeTimer probe_timer_;
+    uint64_t bucket_ns_;
+    size_t buckets_per_shard_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    alignas(64) std::atomic<uint32_t> word_{0}; // Generation and state; read on every submit
+    alignas(64) std::atomic<uint64_t> reopen_at_ns_{0};
+    std::atomic<uint32_t> reopen_generation_{0};
+    std::atomic<uint64_t> probe_deadline_ns_{0};
+    std::atomic<uint32_t> probe_generation_{0};
+    std::atomic<uint64_t> next_eval_ns_{0};
+    std::atomic<uint64_t> closed_at_epoch_{0};
+    std::atomic<uint32_t> probes_left_{0};
+    std::atomic<uint32_t> probe_successes_{0};
+    std::atomic<uint64_t> trips_{0};
+    std::atomic<uint64_t> rejections_{0};
+};
+
+// --- Breaker Registry ---
+// One breaker per downstream, keyed by TaskType and optionally by producer,
+// so a failing dependency sheds only its own traffic. Breakers sit in a flat
+// array and lookup is index arithmetic: type * producer_slots + producer
+// slot.
+class BreakerRegistry {
+public:
+    static constexpr size_t TASK_TYPES = TASK_TYPE_COUNT;
+
+    struct Config {
+        std::array<CircuitBreaker::Config, TASK_TYPES> per_type{}; // Thresholds per TaskType
+        size_t producer_slots = 1; // > 1: also key by producer_id % producer_slots
+    };
+
+    BreakerRegistry(Config config, size_t shards, TimerWheel* timers = nullptr)
+        : producer_slots_(std::max<size_t>(config.producer_slots, 1)) {
+        breakers_.reserve(TASK_TYPES * producer_slots_);
+        for (size_t t = 0; t < TASK_TYPES; ++t) {
+            for (size_t p = 0; p < producer_slots_; ++p) {
+                std::string name = producer_slots_ > 1 ? std::format("Breaker[{}/p{}]", task_type_names[t], p)
+                                                       : std::format("Breaker[{}]", task_type_names[t]);
+                breakers_.push_back(std::make_unique<CircuitBreaker>(config.per_type[t], shards, std::move(name), timers));
+            }
+        }
+    }
+
+    CircuitBreaker& for_item(const WorkItem& item) {
+        return *breakers_[static_cast<size_t>(item.payload.type) * producer_slots_ + item.producer_id % producer_slots_];
+    }
+
+    size_t size() const { return breakers_.size(); }
+    const CircuitBreaker& at(size_t i) const { return *breakers_[i]; }
+
+private:
+    size_t producer_slots_;
+    std::vector<std::unique_ptr<CircuitBreaker>> breakers_;
 };
 
 // ============================================================================
 // SECTION 7: MAIN PROCESSING ENGINE
 // ============================================================================
 
+// --- IO Completion Reactor ---
+// Stands in for an epoll/io_uring completion path: IO-bound items wait on
+// the timer wheel for their (simulated) completion instead of holding a
+// worker in sleep_for, and complete on the wheel thread. Each in-flight
+// item lives in a preallocated IoOp whose timer is linked straight into
+// the wheel, so submit is a free-list pop plus a pointer insert. A full
+// reactor refuses the item, which the engine counts as a downstream
+// failure.
+class IoReactor {
+public:
+    using Completion = std::function<void(const WorkItem&)>;
+
+    IoReactor(TimerWheel& timers, size_t capacity, Completion on_complete)
+        : timers_(timers),
+          on_complete_(std::move(on_complete)),
+          ops_(std::make_unique<IoOp[]>(std::max<size_t>(capacity, 1))) {
+        free_ops_.reserve(std::max<size_t>(capacity, 1));
+        for (size_t i = 0; i < std::max<size_t>(capacity, 1); ++i) {
+            ops_[i].owner = this;
+            free_ops_.push_back(&ops_[i]);
+        }
+    }
+
+    ~IoReactor() { stop(); }
+
+    // False if the reactor is full or stopping
+    bool submit(const WorkItem& item, uint64_t deadline_ns) {
+        IoOp* op;
+        {
+            std::lock_guard<SpinLock> lock(free_lock_);
+            if (stopping_ || free_ops_.empty()) return false;
+            op = free_ops_.back();
+            free_ops_.pop_back();
+            size_t depth = in_flight_.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (depth > peak_in_flight_.load(std::memory_order_relaxed)) {
+                peak_in_flight_.store(depth, std::memory_order_relaxed);
+            }
+        }
+        op->item = item;
+        timers_.schedule(*op, deadline_ns);
+        return true;
+    }
+
+    // Refuses new items and waits for everything in flight to complete
+    void stop() {
+        {
+            std::lock_guard<SpinLock> lock(free_lock_);
+            stopping_ = true;
+        }
+        for (size_t n; (n = in_flight_.load(std::memory_order_acquire)) != 0; ) {
+            in_flight_.wait(n, std::memory_order_acquire);
+        }
+    }
+
+    size_t in_flight() const { return in_flight_.load(std::memory_order_relaxed); }
+    size_t peak_in_flight() const { return peak_in_flight_.load(std::memory_order_relaxed); }
+    uint64_t completed() const { return completed_.load(std::memory_order_relaxed); }
+
+private:
+    struct IoOp final : TimerWheel::Timer {
+        IoReactor* owner = nullptr;
+        WorkItem item{};
+        void on_expire() override { owner->complete(*this); }
+    };
+
+    // Wheel thread
+    void complete(IoOp& op) {
+        on_complete_(op.item);
+        completed_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<SpinLock> lock(free_lock_);
+            free_ops_.push_back(&op);
+        }
+        if (in_flight_.fetch_sub(1, std::memory_order_acq_rel) == 1) in_flight_.notify_all();
+    }
+
+    TimerWheel& timers_;
+    Completion on_complete_;
+    std::unique_ptr<IoOp[]> ops_;
+    std::vector<IoOp*> free_ops_; // Guarded by free_lock_
+    SpinLock free_lock_;
+    bool stopping_ = false;       // Guarded by free_lock_
+    std::atomic<size_t> in_flight_{0};
+    std::atomic<size_t> peak_in_flight_{0};
+    std::atomic<uint64_t> completed_{0};
+};
+
 class TitanEngine {
 public:
     struct Config {
         size_t queue_capacity = 1024;
         size_t num_workers = 4;
-        double circuit_failure_rate = 0.5; // 50% failure trips breaker
+        BreakerRegistry::Config breakers{}; // Per-TaskType thresholds (default: 50% failure trips)
+        uint64_t spin_before_park_ns = 20'000; // Idle workers poll this long before parking
+        size_t dequeue_batch = 16; // Max items a worker takes per dequeue and runs to completion
+        DequeuePolicy dequeue{};   // How HIGH/NORMAL/LOW share workers behind CRITICAL
+        size_t max_io_in_flight = 16'384; // IO_BOUND items waiting on the reactor
+        uint64_t timer_tick_ns = 100'000;  // Timer wheel resolution (IO delays, breaker reset)
     };
 
+    // What a worker did with an item. DEFERRED items are counted when the
+    // reactor completes them.
+    enum class ItemOutcome : uint8_t { SUCCEEDED, FAILED, DEFERRED };
+
     explicit TitanEngine(Config config)
         : config_(config),
-          router_(config.queue_capacity),
-          circuit_breaker_(config.circuit_failure_rate, 2000), // 2s reset
-          running_(true) {
+          timers_(config.timer_tick_ns),
+          router_(config.queue_capacity, config.dequeue),
+          breakers_(config.breakers, config.num_workers + 1, &timers_), // One counter shard per worker, plus the wheel thread
+          metrics_(config.num_workers + 1), // Same recorders as breakers_
+          io_(timers_, config.max_io_in_flight, [this](const WorkItem& item) { complete_io(item); }),
+          running_(true),
+          parkers_(std::make_unique<Parker[]>(config.num_workers)) {
+        idle_workers_.reserve(config.num_workers);
         
         LOG_INFO(std::format("Initializing TitanEngine with {} workers", config.num_workers));
         start_workers();
@@ -527,11 +1664,14 @@ public:
     bool submit(WorkItem item) {
         if (!running_.load()) return false;
 
-        // 1. Check Circuit Breaker
-        if (!circuit_breaker_.allow_request()) {
-            metrics_.tasks_rejected_circuit_open.fetch_add(1);
+        // 1. Check the item's downstream breaker
+        CircuitBreaker& breaker = breakers_.for_item(item);
+        auto generation = breaker.admit();
+        if (!generation) {
+            metrics_.tasks_rejected_circuit_open.fetch_add(1, std::memory_order_relaxed);
             return false; 
         }
+        item.breaker_generation = *generation;
 
         // 2. Try Enqueue
         bool accepted = router_.try_push(std::move(item));
@@ -539,8 +1679,9 @@ public:
         if (accepted) {
             metrics_.tasks_submitted.fetch_add(1, std::memory_order_relaxed);
             metrics_.current_queue_depth.store(router_.total_size(), std::memory_order_relaxed);
-            work_available_cv_.notify_one();
+            wake_one();
         } else {
+            breaker.refund_probe(*generation); // A HALF_OPEN probe that never ran goes back
             metrics_.tasks_rejected_queue_full.fetch_add(1, std::memory_order_relaxed);
         }
 
@@ -551,15 +1692,20 @@ public:
         bool expected = true;
         if (running_.compare_exchange_strong(expected, false)) {
             LOG_INFO("Stopping TitanEngine...");
-            work_available_cv_.notify_all();
+            wake_all();
             for (auto& t : workers_) {
                 if (t.joinable()) t.join();
             }
+            io_.stop();     // Workers are gone; let in-flight IO finish
+            timers_.stop(); // Pending breaker resets are moot now
             LOG_INFO("TitanEngine Stopped.");
         }
     }
 
     const SystemMetrics& get_metrics() const { return metrics_; }
+    const PriorityRouter& get_router() const { return router_; }
+    const BreakerRegistry& get_breakers() const { return breakers_; }
+    const IoReactor& get_io() const { return io_; }
 
 private:
     void start_workers() {
@@ -571,30 +1717,124 @@ private:
 
     void worker_loop(size_t worker_id) {
         LOG_INFO(std::format("Worker {} started", worker_id));
+
+        // Run to completion: take a batch, process all of it, then publish
+        // the batch's counters once. A CRITICAL item that arrives mid-batch
+        // waits at most one batch on this worker (others may still take it).
+        std::vector<WorkItem> batch(std::max<size_t>(config_.dequeue_batch, 1));
+        PriorityRouter::ConsumerState turn; // This worker's WRR/DRR position
         
-        while (running_.load() || router_.total_size() > 0) {
-            std::unique_lock<std::mutex> lock(cv_mutex_);
-            work_available_cv_.wait(lock, [this] {
-                return !running_.load() || router_.total_size() > 0;
-            });
+        while (true) {
+            // Try to fetch work
+            size_t count = router_.try_pop_batch(batch, turn);
+            if (count > 0) {
+                uint64_t processed = 0, failed = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    switch (process_item(worker_id, batch[i])) {
+                        case ItemOutcome::SUCCEEDED: ++processed; break;
+                        case ItemOutcome::FAILED: ++failed; break;
+                        case ItemOutcome::DEFERRED: break;
+                    }
+                }
+                metrics_.tasks_processed.fetch_add(processed, std::memory_order_relaxed);
+                if (failed) metrics_.tasks_failed.fetch_add(failed, std::memory_order_relaxed);
+                metrics_.dequeue_batches.fetch_add(1, std::memory_order_relaxed);
+                metrics_.current_queue_depth.store(router_.total_size(), std::memory_order_relaxed);
+                continue;
+            }
 
             if (!running_.load() && router_.total_size() == 0) break;
+            if (spin_for_work()) continue;
+            park(worker_id);
+        }
+        LOG_INFO(std::format("Worker {} exiting", worker_id));
+    }
 
-            // Unlock to allow other workers to wake up
-            lock.unlock();
+    // --- Worker Parking ---
+    // An idle worker polls for spin_before_park_ns, then pushes itself on the
+    // idle stack and sleeps on its own futex word (atomic wait). submit()
+    // wakes exactly one parked worker, and only if parked_count_ says one
+    // exists, so a saturated engine makes no wake syscalls at all.
+    //
+    // Lost wakeups are excluded Dekker-style: the parker publishes
+    // parked_count_, fences, then re-checks the router; the submitter
+    // publishes the item (router push), fences, then reads parked_count_.
+    // At least one of them sees the other.
+
+    enum ParkState : uint32_t { RUNNING = 0, PARKED = 1, NOTIFIED = 2 };
+
+    struct alignas(64) Parker {
+        std::atomic<uint32_t> state{RUNNING};
+    };
 
-            // Try to fetch work
-            auto item_opt = router_.try_pop();
-            if (item_opt.has_value()) {
-                WorkItem item = std::move(item_opt.value());
-                process_item(worker_id, item);
-                metrics_.current_queue_depth.store(router_.total_size(), std::memory_order_relaxed);
+    // True if work (or shutdown) showed up within the spin budget.
+    bool spin_for_work() {
+        uint64_t deadline = now_ns() + config_.spin_before_park_ns;
+        do {
+            if (router_.total_size() > 0 || !running_.load(std::memory_order_relaxed)) return true;
+            cpu_relax();
+        } while (now_ns() < deadline);
+        return false;
+    }
+
+    void park(size_t worker_id) {
+        Parker& self = parkers_[worker_id];
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            self.state.store(PARKED, std::memory_order_relaxed);
+            idle_workers_.push_back(worker_id);
+            parked_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (router_.total_size() > 0 || !running_.load(std::memory_order_relaxed)) {
+            // Work arrived while we were registering: take ourselves back off
+            // the stack, unless a waker already claimed us.
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            if (self.state.load(std::memory_order_relaxed) == PARKED) {
+                std::erase(idle_workers_, worker_id);
+                parked_count_.fetch_sub(1, std::memory_order_relaxed);
             }
+            self.state.store(RUNNING, std::memory_order_relaxed);
+            return;
         }
-        LOG_INFO(std::format("Worker {} exiting", worker_id));
+
+        metrics_.worker_parks.fetch_add(1, std::memory_order_relaxed);
+        self.state.wait(PARKED, std::memory_order_acquire);
+        self.state.store(RUNNING, std::memory_order_relaxed);
+    }
+
+    void wake_one() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_count_.load(std::memory_order_relaxed) == 0) return; // Nobody asleep: no syscall
+
+        size_t worker_id;
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            if (idle_workers_.empty()) return;
+            worker_id = idle_workers_.back(); // LIFO: the most recently idle worker has the warmest cache
+            idle_workers_.pop_back();
+            parked_count_.fetch_sub(1, std::memory_order_relaxed);
+            parkers_[worker_id].state.store(NOTIFIED, std::memory_order_release);
+        }
+        parkers_[worker_id].state.notify_one();
+        metrics_.worker_wakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void wake_all() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        for (size_t worker_id : idle_workers_) {
+            parkers_[worker_id].state.store(NOTIFIED, std::memory_order_release);
+            parkers_[worker_id].state.notify_one();
+        }
+        idle_workers_.clear();
+        parked_count_.store(0, std::memory_order_relaxed);
     }
 
-    void process_item(size_t worker_id, const WorkItem& item) {
+    // The caller publishes processed/failed counts per batch. IO_BOUND items
+    // go to the reactor, so workers only ever spend time on CPU work.
+    ItemOutcome process_item(size_t worker_id, const WorkItem& item) {
         auto start = now_ns();
 
         // Simulate work based on payload type
@@ -606,8 +1846,11 @@ private:
                     simulate_cpu_load(item.payload.complexity_score);
                     break;
                 case TaskType::IO_BOUND:
-                    // Network wait simulation
-                    std::this_thread::sleep_for(std::chrono::microseconds(100 * item.payload.complexity_score));
+                    // Network wait simulation: completes on the timer wheel thread
+                    if (io_.submit(item, start + 100'000 * uint64_t{item.payload.complexity_score})) {
+                        return ItemOutcome::DEFERRED;
+                    }
+                    success = false; // Reactor full: the downstream is saturated
                     break;
                 case TaskType::ADMINISTRATIVE:
                     // Fast path
@@ -621,13 +1864,10 @@ private:
         uint64_t latency_us = (end - item.created_at_ns) / 1000;
 
         // Update Stats
-        circuit_breaker_.record_result(success);
+        breakers_.for_item(item).record_result(worker_id, success, item.breaker_generation);
         
         if (success) {
-            metrics_.tasks_processed.fetch_add(1, std::memory_order_relaxed);
-            metrics_.processing_latency_us.record(latency_us);
-        } else {
-            metrics_.tasks_failed.fetch_add(1, std::memory_order_relaxed);
+            metrics_.processing_latency_us.record(latency_us, worker_id);
         }
 
         // Trace logging for Critical items only to reduce noise
@@ -635,6 +1875,14 @@ private:
             // Uncomment for verbose debugging
             // LOG_INFO(std::format("Worker {} finished CRITICAL item {}", worker_id, item.id));
         }
+        return success ? ItemOutcome::SUCCEEDED : ItemOutcome::FAILED;
+    }
+
+    // Wheel thread: an IO_BOUND item's wait is over
+    void complete_io(const WorkItem& item) {
+        breakers_.for_item(item).record_result(config_.num_workers, true, item.breaker_generation);
+        metrics_.processing_latency_us.record((now_ns() - item.created_at_ns) / 1000, config_.num_workers);
+        metrics_.tasks_processed.fetch_add(1, std::memory_order_relaxed);
     }
 
     void simulate_cpu_load(uint32_t difficulty) {
@@ -646,14 +1894,19 @@ private:
     }
 
     Config config_;
+    TimerWheel timers_; // First: breakers_ and io_ hold timers linked into it
     PriorityRouter router_;
-    CircuitBreaker circuit_breaker_;
+    BreakerRegistry breakers_;
     SystemMetrics metrics_;
+    IoReactor io_;  // After metrics_ and breakers_: its completions use both
 
     std::atomic<bool> running_;
     std::vector<std::jthread> workers_;
-    std::mutex cv_mutex_;
-    std::condition_variable work_available_cv_;
+
+    std::unique_ptr<Parker[]> parkers_;  // One futex word per worker
+    std::vector<size_t> idle_workers_;   // Parked workers, LIFO; guarded by idle_mutex_
+    std::mutex idle_mutex_;              // Taken only on park/wake transitions
+    alignas(64) std::atomic<size_t> parked_count_{0}; // Read lock-free on every submit
 };
 
 // ============================================================================
@@ -662,8 +1915,9 @@ private:
 
 class ProducerGroup {
 public:
-    ProducerGroup(TitanEngine& engine, size_t count, std::string name)
-        : engine_(engine), count_(count), name_(std::move(name)) {}
+    // bulk_priority: class of the non-CRITICAL, non-HIGH half of the traffic
+    ProducerGroup(TitanEngine& engine, size_t count, std::string name, Priority bulk_priority = Priority::NORMAL)
+        : engine_(engine), count_(count), name_(std::move(name)), bulk_priority_(bulk_priority) {}
 
     void start(uint64_t duration_ms) {
         for (size_t i = 0; i < count_; ++i) {
@@ -687,9 +1941,9 @@ private:
         // Burstiness parameters
         std::exponential_distribution<double> sleep_dist(1.0 / 500.0); // Avg 500us
 
-        auto end_time = Clock::now() + std::chrono::milliseconds(duration_ms);
+        uint64_t end_ns = coarse_now_ns() + duration_ms * 1'000'000;
 
-        while (Clock::now() < end_time) {
+        while (coarse_now_ns() < end_ns) {
             WorkItem item;
             item.id = SnowflakeId::generate();
             item.created_at_ns = now_ns();
@@ -699,7 +1953,7 @@ private:
             int p_roll = prio_dist(rng);
             if (p_roll == 0) item.priority = Priority::CRITICAL; // 25% chance
             else if (p_roll == 1) item.priority = Priority::HIGH;
-            else item.priority = Priority::NORMAL; // Skew towards Normal
+            else item.priority = bulk_priority_; // Skew towards the group's bulk class
 
             // Payload
             item.payload.type = static_cast<TaskType>(type_dist(rng));
@@ -721,11 +1975,233 @@ private:
     TitanEngine& engine_;
     size_t count_;
     std::string name_;
+    Priority bulk_priority_;
     std::vector<std::jthread> threads_;
 };
 
 // ============================================================================
-// SECTION 9: REPORTING & MAIN
+// SECTION 9: MICROBENCHMARKS
+// ============================================================================
+
+// Router queue throughput: every thread alternates push and pop on one
+// shared queue (the enqueue/dequeue pair workload), so producers and
+// consumers contend at every thread count. WorkItem metadata is inline, so
+// no allocation is measured.
+template <typename Queue>
+double bench_queue_mops(size_t threads, size_t pairs_per_thread) {
+    Queue queue(1024);
+    std::barrier sync(static_cast<std::ptrdiff_t>(threads) + 1);
+    std::vector<std::jthread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            sync.arrive_and_wait();
+            for (size_t i = 0; i < pairs_per_thread; ++i) {
+                WorkItem item{};
+                item.id = t * pairs_per_thread + i;
+                while (!queue.try_push(std::move(item))) std::this_thread::yield();
+                while (!queue.pop()) std::this_thread::yield();
+            }
+        });
+    }
+    sync.arrive_and_wait();
+    auto start = Clock::now();
+    pool.clear(); // Join
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return 2.0 * static_cast<double>(threads * pairs_per_thread) / elapsed.count() / 1e6;
+}
+
+// Smallest rings (the router asks for base_capacity / 4, which can be 0 or
+// 1): fill, overfill, drain in order, underflow.
+bool check_small_rings() {
+    for (size_t cap : {0, 1, 2}) {
+        MpmcRing<WorkItem> ring(cap);
+        WorkItem a{}, b{}, c{};
+        a.id = 1;
+        b.id = 2;
+        c.id = 3;
+        bool ok = ring.try_push(std::move(a)) && ring.try_push(std::move(b)) && !ring.try_push(std::move(c));
+        auto first = ring.pop();
+        auto second = ring.pop();
+        ok = ok && first && first->id == 1 && second && second->id == 2 && !ring.pop();
+        if (!ok) {
+            std::cout << "Small-capacity ring check FAILED for capacity " << cap << "\n";
+            return false;
+        }
+    }
+    std::cout << "Small-capacity ring check: ok\n";
+    return true;
+}
+
+// HALF_OPEN recovery when probes go missing. Full router: every probe
+// bounces off the queue and must be refunded, so the breaker keeps
+// admitting and closes once the queue drains. Lost probes: admitted, never
+// reported; the probe timeout reopens the breaker and the next HALF_OPEN
+// recovers. The lost-probe case runs with and without a wheel.
+bool check_breaker_recovery() {
+    using State = CircuitBreaker::State;
+    const CircuitBreaker::Config cfg{.reset_timeout_ms = 20, .min_requests = 1, .half_open_probes = 3,
+                                     .probe_timeout_ms = 50};
+    auto wait_until = [](auto&& done) {
+        for (uint64_t deadline = now_ns() + 2'000'000'000; !done(); std::this_thread::sleep_for(std::chrono::milliseconds(1))) {
+            if (now_ns() > deadline) return false;
+        }
+        return true;
+    };
+    auto fail = [](const char* what) {
+        std::cout << "Breaker recovery check FAILED: " << what << "\n";
+        return false;
+    };
+
+    // The wheel stops before the breaker goes, as in TitanEngine: a timer
+    // may still be firing into it
+    struct Rig {
+        TimerWheel wheel;
+        CircuitBreaker breaker;
+        Rig(const CircuitBreaker::Config& cfg, const char* name, bool use_wheel)
+            : breaker(cfg, 1, name, use_wheel ? &wheel : nullptr) {}
+        ~Rig() { wheel.stop(); }
+    };
+
+    {
+        Rig rig(cfg, "Breaker[check-full]", true);
+        CircuitBreaker& breaker = rig.breaker;
+        PriorityRouter router(4);
+        WorkItem item{};
+        item.priority = Priority::NORMAL;
+        while (router.try_push(WorkItem{item})) {}
+        size_t queue_full = 0;
+        auto submit = [&] { // TitanEngine::submit without the engine
+            auto generation = breaker.admit();
+            if (!generation) return false;
+            WorkItem probe = item;
+            probe.breaker_generation = *generation;
+            if (router.try_push(std::move(probe))) return true;
+            breaker.refund_probe(*generation);
+            ++queue_full;
+            return false;
+        };
+
+        breaker.record_result(0, false, breaker.generation());
+        if (!wait_until([&] { return breaker.state() == State::HALF_OPEN; })) return fail("never reached HALF_OPEN");
+        for (int i = 0; i < 20; ++i) submit();
+        if (queue_full != 20) return fail("queue-full probes were not refunded");
+        while (router.try_pop()) {}
+        for (uint32_t i = 0; i < cfg.half_open_probes; ++i) {
+            if (!submit()) return fail("no probe after the queue drained");
+        }
+        while (auto done = router.try_pop()) breaker.record_result(0, true, done->breaker_generation);
+        if (breaker.state() != State::CLOSED) return fail("did not close after a full queue");
+    }
+
+    for (bool use_wheel : {true, false}) {
+        Rig rig(cfg, "Breaker[check-lost]", use_wheel);
+        CircuitBreaker& breaker = rig.breaker;
+        breaker.record_result(0, false, breaker.generation());
+        std::optional<uint32_t> probe;
+        if (!wait_until([&] { return (probe = breaker.admit()).has_value(); })) return fail("no first probe");
+        for (uint32_t i = 1; i < cfg.half_open_probes; ++i) {
+            if (!breaker.admit()) return fail("probe budget too small");
+        }
+        if (breaker.admit()) return fail("probe budget too large");
+        uint32_t lost = *probe; // None of these report back
+        if (!wait_until([&] { return (probe = breaker.admit()) && *probe != lost; })) return fail("stuck after lost probes");
+        for (uint32_t i = 1; i < cfg.half_open_probes; ++i) breaker.admit();
+        for (uint32_t i = 0; i < cfg.half_open_probes; ++i) breaker.record_result(0, true, *probe);
+        if (breaker.state() != State::CLOSED || breaker.trips() != 2) return fail("did not close after lost probes");
+    }
+    std::cout << "Breaker recovery check: ok\n";
+    return true;
+}
+
+void run_queue_benchmark() {
+    constexpr size_t TOTAL_PAIRS = 1 << 20;
+    std::cout << "Router queue benchmark: push+pop pairs on one queue, Mops/s\n";
+    std::cout << std::format("{:>8} {:>12} {:>12} {:>8}\n", "threads", "spinlock", "mpmc", "speedup");
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        size_t pairs = TOTAL_PAIRS / threads;
+        double spin = bench_queue_mops<SpinLockRing<WorkItem>>(threads, pairs);
+        double mpmc = bench_queue_mops<MpmcRing<WorkItem>>(threads, pairs);
+        std::cout << std::format("{:>8} {:>12.2f} {:>12.2f} {:>7.2f}x\n", threads, spin, mpmc, mpmc / spin);
+    }
+}
+
+// Heap allocations on the item path: submit -> router push -> batch pop ->
+// process_item. Engine construction and worker startup happen before the
+// window opens and shutdown after it closes; the window covers submitting
+// ITEMS items and draining all of them.
+bool run_alloc_benchmark() {
+    constexpr uint64_t ITEMS = 200'000;
+    TitanEngine::Config config;
+    config.queue_capacity = 4096;
+    config.num_workers = std::max(2u, std::thread::hardware_concurrency());
+    TitanEngine engine(config);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Workers started and logged
+
+    g_heap_allocations.store(0);
+    g_count_allocations.store(true);
+    auto start = Clock::now();
+    for (uint64_t i = 0; i < ITEMS; ++i) {
+        WorkItem item{};
+        item.id = SnowflakeId::generate();
+        item.created_at_ns = now_ns();
+        item.priority = static_cast<Priority>(i % 4);
+        item.payload.type = TaskType::ADMINISTRATIVE;
+        item.payload.metadata = "Simulated Request";
+        while (!engine.submit(item)) std::this_thread::yield();
+    }
+    while (engine.get_metrics().tasks_processed.load() < ITEMS) std::this_thread::yield();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    g_count_allocations.store(false);
+    uint64_t allocations = g_heap_allocations.load();
+    engine.stop();
+
+    std::cout << "Allocation benchmark: " << ITEMS << " items submitted and processed\n";
+    std::cout << std::format("Heap allocations:   {} ({:.4f} per item)\n", allocations,
+                             static_cast<double>(allocations) / ITEMS);
+    std::cout << std::format("Throughput:         {:.2f} Mitems/s\n", ITEMS / elapsed.count() / 1e6);
+    return allocations == 0;
+}
+
+// Cost of one clock read, and what the clocks cost each item. An item
+// reads the precise clock three times (created_at_ns, process_item start
+// and end) and the coarse clock twice (SnowflakeId, breaker bucket); all
+// five used to be steady_clock reads.
+static volatile uint64_t clock_sink; // Keeps the timed reads alive
+
+template <typename Read>
+double clock_read_ns(Read read) {
+    constexpr int READS = 5'000'000;
+    uint64_t sink = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < READS; ++i) sink += read();
+    std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+    clock_sink = sink;
+    return elapsed.count() / READS;
+}
+
+void run_clock_benchmark() {
+    coarse_now_ns(); // Calibrate and start the ticker outside the timed loops
+    double steady = clock_read_ns([] { return static_cast<uint64_t>(Clock::now().time_since_epoch().count()); });
+    double precise = clock_read_ns([] { return now_ns(); });
+    double coarse = clock_read_ns([] { return coarse_now_ns(); });
+
+    if (TscClock::uses_tsc()) {
+        std::cout << std::format("Precise clock: invariant TSC, calibrated at {:.3f} GHz\n", TscClock::ghz());
+    } else {
+        std::cout << "Precise clock: steady_clock (no invariant TSC)\n";
+    }
+    std::cout << std::format("{:<22}{:>10}\n", "clock", "ns/read");
+    std::cout << std::format("{:<22}{:>10.2f}\n", "steady_clock::now", steady);
+    std::cout << std::format("{:<22}{:>10.2f}\n", "now_ns (TSC)", precise);
+    std::cout << std::format("{:<22}{:>10.2f}\n", "coarse_now_ns", coarse);
+    double before = 5 * steady;
+    double after = 3 * precise + 2 * coarse;
+    std::cout << std::format("Per item: {:.1f} ns -> {:.1f} ns ({:.1f}x less clock overhead)\n", before, after,
+                             after > 0 ? before / after : 0.0);
+}
+
+// ============================================================================
+// SECTION 10: REPORTING & MAIN
 // ============================================================================
 
 void print_final_report(const TitanEngine& engine, double duration_s) {
@@ -753,21 +2229,90 @@ void print_final_report(const TitanEngine& engine, double duration_s) {
     std::cout << "Queue Full Rejects: " << q_rej << " (" 
               << (total ? (100.0 * q_rej / total) : 0.0) << "%)\n";
     std::cout << "Circuit Breaks:     " << c_rej << "\n";
+
+    static constexpr std::array<const char*, 3> state_names{"CLOSED", "OPEN", "HALF_OPEN"};
+    const auto& breakers = engine.get_breakers();
+    std::cout << "\n--- Circuit Breakers ---\n";
+    for (size_t i = 0; i < breakers.size(); ++i) {
+        const auto& b = breakers.at(i);
+        std::cout << std::format("{:<32}{:<10} trips {:<4} rejected {}\n", b.name() + ":",
+                                 state_names[static_cast<size_t>(b.state())], b.trips(), b.rejections());
+    }
+
+    static constexpr std::array<const char*, 4> class_names{"CRITICAL", "HIGH", "NORMAL", "LOW"};
+    static constexpr std::array<const char*, 4> discipline_names{"STRICT", "WRR", "DRR", "AGE_BOOST"};
+    const auto& router = engine.get_router();
+    auto dequeued = router.dequeued();
+    uint64_t dequeued_total = std::accumulate(dequeued.begin(), dequeued.end(), uint64_t{0});
+    std::cout << "\n--- Dequeue (" << discipline_names[static_cast<size_t>(router.policy().discipline)] << ") ---\n";
+    for (size_t c = 0; c < dequeued.size(); ++c) {
+        std::cout << std::format("{:<20}{} ({:.2f}%)\n", std::string(class_names[c]) + ":", dequeued[c],
+                                 dequeued_total ? 100.0 * dequeued[c] / dequeued_total : 0.0);
+    }
+
+    std::cout << "\n--- Workers ---\n";
+    uint64_t batches = m.dequeue_batches.load();
+    std::cout << "Dequeue Batches:    " << batches << " (avg "
+              << (batches ? static_cast<double>(processed + m.tasks_failed.load()) / batches : 0.0) << " items)\n";
+    std::cout << "Parks / Wakeups:    " << m.worker_parks.load() << " / " << m.worker_wakeups.load()
+              << " (" << (total ? static_cast<double>(m.worker_wakeups.load()) / total : 0.0) << " wakeups per item)\n";
+    std::cout << "Async IO Completed: " << engine.get_io().completed() << " (peak "
+              << engine.get_io().peak_in_flight() << " in flight)\n";
     
+    auto latency = m.processing_latency_us.snapshot();
     std::cout << "\n--- Latency (us) ---\n";
-    std::cout << "Mean Latency:       " << m.processing_latency_us.get_mean() << " us\n";
-    std::cout << "P50  Latency:       " << m.processing_latency_us.get_percentile(0.50) << " us\n";
-    std::cout << "P90  Latency:       " << m.processing_latency_us.get_percentile(0.90) << " us\n";
-    std::cout << "P99  Latency:       " << m.processing_latency_us.get_percentile(0.99) << " us\n";
+    std::cout << "Mean Latency:       " << latency.mean() << " us\n";
+    std::cout << "P50  Latency:       " << latency.percentile(0.50) << " us\n";
+    std::cout << "P90  Latency:       " << latency.percentile(0.90) << " us\n";
+    std::cout << "P99  Latency:       " << latency.percentile(0.99) << " us\n";
+    std::cout << "P99.9 Latency:      " << latency.percentile(0.999) << " us\n";
+    std::cout << "Max  Latency:       " << latency.max() << " us\n";
     std::cout << "========================================================\n";
 }
 
-int main() {
-    // Configure System
+int main(int argc, char** argv) {
+    // --bench-queue: compare the MPMC router queue with the spinlock ring
+    // --bench-alloc: count heap allocations per item on the submit/process path
+    // --bench-clock: clock read cost (steady_clock vs TSC vs coarse) per item
+    // --check-breakers: HALF_OPEN recovery with a full router or lost probes
+    // --dequeue strict|wrr|drr|age: router discipline for HIGH/NORMAL/LOW
+    // --breaker-producers N: key circuit breakers by producer_id % N as well as TaskType
     TitanEngine::Config config;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--bench-queue") {
+            if (!check_small_rings()) return 1;
+            run_queue_benchmark();
+            return 0;
+        }
+        if (arg == "--bench-alloc") {
+            return run_alloc_benchmark() ? 0 : 1;
+        }
+        if (arg == "--bench-clock") {
+            run_clock_benchmark();
+            return 0;
+        }
+        if (arg == "--check-breakers") {
+            bool ok = check_breaker_recovery();
+            AsyncLogger::instance().shutdown();
+            return ok ? 0 : 1;
+        }
+        if (arg == "--dequeue" && i + 1 < argc) {
+            std::string_view d = argv[++i];
+            if (d == "wrr") config.dequeue.discipline = DequeueDiscipline::WRR;
+            else if (d == "drr") config.dequeue.discipline = DequeueDiscipline::DRR;
+            else if (d == "age") config.dequeue.discipline = DequeueDiscipline::AGE_BOOST;
+            else config.dequeue.discipline = DequeueDiscipline::STRICT;
+        }
+        if (arg == "--breaker-producers" && i + 1 < argc) {
+            config.breakers.producer_slots = std::stoul(argv[++i]);
+        }
+    }
+
+    // Configure System
     config.queue_capacity = 2000;
     config.num_workers = std::thread::hardware_concurrency(); 
-    config.circuit_failure_rate = 0.2; // Strict breaker
+    for (auto& b : config.breakers.per_type) b.failure_threshold = 0.2; // Strict breakers
 
     std::cout << "Starting TITAN GATE System...\n";
     std::cout << "Workers: " << config.num_workers << "\n";
@@ -779,8 +2324,8 @@ int main() {
     // Group 1: High Frequency web requests
     ProducerGroup web_producers(engine, 4, "WebFrontend");
     
-    // Group 2: Heavy Batch jobs (lower frequency, high cost)
-    ProducerGroup batch_producers(engine, 2, "BatchBackend");
+    // Group 2: Heavy Batch jobs (lower frequency, high cost, LOW priority bulk)
+    ProducerGroup batch_producers(engine, 2, "BatchBackend", Priority::LOW);
 
     auto start_time = Clock::now();
 
@@ -789,13 +2334,23 @@ int main() {
     web_producers.start(5000);   // Run for 5 seconds
     batch_producers.start(5000); // Run for 5 seconds
 
-    // Monitor Loop (runs on main thread)
+    // Monitor Loop (runs on main thread): latency over the last second only.
+    // The three merge buffers are allocated once and reused every second.
+    const HdrHistogram& latency_hist = engine.get_metrics().processing_latency_us;
+    auto last_latency = latency_hist.snapshot();
+    auto latency = last_latency;
+    auto interval = last_latency;
     for (int i = 0; i < 5; ++i) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
         auto depth = engine.get_metrics().current_queue_depth.load();
         auto processed = engine.get_metrics().tasks_processed.load();
+        latency_hist.snapshot(latency);
+        interval = latency;
+        interval -= last_latency;
+        std::swap(latency, last_latency);
         std::cout << "[Monitor] Queue Depth: " << depth 
-                  << " | Processed: " << processed << "\n";
+                  << " | Processed: " << processed
+                  << " | P50/P99 (1s): " << interval.percentile(0.50) << "/" << interval.percentile(0.99) << " us\n";
     }
 
     // Join Producers